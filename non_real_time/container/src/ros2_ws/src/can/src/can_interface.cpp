@@ -12,6 +12,7 @@
 #include <unistd.h>
 
 #include <linux/can/isotp.h>
+#include <linux/can/raw.h>
 #include <net/if.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
@@ -22,6 +23,9 @@
 
 using json = nlohmann::json;
 
+// SYNC broadcast id, TIME_SYNC_CAN_ID in the leg firmware (time_sync.hpp)
+static constexpr uint32_t kTimeSyncCanId = 0x080;
+
 // ===================== Constructor =====================
 
 CanInterface::CanInterface()
@@ -35,6 +39,20 @@ CanInterface::CanInterface()
   std::string config_file =
     this->declare_parameter<std::string>("leg_groups_config", "");
 
+  // 0 disables: SYNC frames stop and commands go out untimed
+  sync_period_ms_ =
+    this->declare_parameter<int>("sync_period_ms", 100);
+  // how far ahead of sending a tick's LINEAR commands they are timed to
+  // start, long enough for all six legs to receive them; 0 sends them untimed
+  execute_lead_ms_ =
+    this->declare_parameter<int>("execute_lead_ms", 10);
+  bus_epoch_ = std::chrono::steady_clock::now();
+
+  if (!init_can_socket()) {
+    RCLCPP_ERROR(get_logger(),
+      "Failed to open raw CAN socket, no SYNC frames will be sent");
+  }
+
   for (uint8_t leg_num = 0; leg_num < 6; leg_num++) {
     uint32_t node_id = node_id_ + leg_num;
     if (!create_isotp_socket(node_id)) {
@@ -79,28 +97,32 @@ CanInterface::CanInterface()
 
 CanInterface::~CanInterface()
 {
-  if (sockfd_ >= 0) {
-    close(sockfd_);
-  }
-
   scheduler_running_ = false;
 
   if (scheduler_thread_.joinable())
   {
       scheduler_thread_.join();
   }
+
+  // after the join, the scheduler thread sends SYNC frames on it
+  if (sockfd_ >= 0) {
+    close(sockfd_);
+  }
 }
 
 // ===================== CAN init =====================
 
 bool CanInterface::init_can_socket()
 {
-  sockfd_ = socket(AF_CAN, SOCK_DGRAM, CAN_ISOTP);
+  sockfd_ = socket(AF_CAN, SOCK_RAW, CAN_RAW);
   if (sockfd_ < 0) {
     RCLCPP_ERROR(get_logger(), "socket() failed: %s", std::strerror(errno));
     return false;
   }
 
+  // transmit only, nothing is read back from this socket
+  setsockopt(sockfd_, SOL_CAN_RAW, CAN_RAW_FILTER, nullptr, 0);
+
   struct ifreq ifr {};
   std::strncpy(ifr.ifr_name, can_interface_.c_str(), IFNAMSIZ - 1);
 
@@ -234,6 +256,7 @@ void CanInterface::scheduler_loop()
     using clock = std::chrono::steady_clock;
 
     auto next_tick = clock::now();
+    auto next_sync = next_tick;
 
     while (scheduler_running_ && rclcpp::ok())
     {
@@ -251,6 +274,13 @@ void CanInterface::scheduler_loop()
             }
         }
 
+        // one execute time for the whole tick, so a leg group starts together
+        uint32_t execute_at_us = 0;
+        if (sync_period_ms_ > 0 && execute_lead_ms_ > 0)
+        {
+            execute_at_us = bus_time_us() + static_cast<uint32_t>(execute_lead_ms_) * 1000U;
+        }
+
         for (size_t leg = 0; leg < commands.size(); ++leg)
         {
             if (!commands[leg].valid)
@@ -260,15 +290,67 @@ void CanInterface::scheduler_loop()
                 node_id_ +
                 static_cast<uint32_t>(leg);
 
+            stamp_execute_time(commands[leg].payload, execute_at_us);
+
             send_isotp(
                 node_id,
                 commands[leg].payload);
         }
 
+        if (sync_period_ms_ > 0 && clock::now() >= next_sync)
+        {
+            next_sync += std::chrono::milliseconds(sync_period_ms_);
+            send_time_sync();
+        }
+
         std::this_thread::sleep_until(next_tick);
     }
 }
 
+// ===================== Time sync =====================
+
+uint32_t CanInterface::bus_time_us() const
+{
+  auto since_epoch = std::chrono::steady_clock::now() - bus_epoch_;
+  // wraps every 71 minutes, the legs compare bus times by signed difference
+  return static_cast<uint32_t>(
+    std::chrono::duration_cast<std::chrono::microseconds>(since_epoch).count());
+}
+
+// SYNC: uint32 bus time, uint8 sequence; every leg hears the same frame
+void CanInterface::send_time_sync()
+{
+  if (sockfd_ < 0) {
+    return;
+  }
+  uint8_t data[5];
+  uint32_t now_us = bus_time_us();
+  std::memcpy(data, &now_us, sizeof(now_us));
+  data[4] = sync_sequence_++;
+  if (!send_can_frame(kTimeSyncCanId, data, sizeof(data))) {
+    RCLCPP_WARN_THROTTLE(get_logger(), *get_clock(), 5000,
+      "SYNC write failed: %s", std::strerror(errno));
+  }
+}
+
+// Append the optional execute time to LINEAR payloads, 0 leaves them untimed.
+// The legs take it as "not before": a leg still busy with a move finishes (or
+// blends out of) it first, an idle leg starts on the tick's common time.
+// RAPID stays untimed, four more bytes would turn its single frame into an
+// ISO-TP transfer with a flow control round trip per leg inside the lead.
+void CanInterface::stamp_execute_time(
+  std::vector<uint8_t>& payload,
+  uint32_t execute_at_us) const
+{
+  if (execute_at_us == 0 || payload.size() != 9 ||
+    payload[0] != hexapod_msgs::msg::LegCommand::LINEAR)
+  {
+    return;
+  }
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(&execute_at_us);
+  payload.insert(payload.end(), p, p + sizeof(execute_at_us));
+}
+
 // ===================== CAN frame =====================
 
 bool CanInterface::send_can_frame(
@@ -6,6 +6,9 @@
 #include <string>
 #include <array>
 #include <mutex>
+#include <atomic>
+#include <chrono>
+#include <thread>
 
 #include <linux/can.h>
 #include "hexapod_msgs/msg/leg_command.hpp"
@@ -48,6 +51,17 @@ private:
 
   void scheduler_loop();
 
+  // Bus time: microseconds since this node started, broadcast to the legs as SYNC
+  // frames so commands can carry the bus time at which every leg starts them
+  std::chrono::steady_clock::time_point bus_epoch_;
+  uint8_t sync_sequence_ = 0;
+  int sync_period_ms_;
+  int execute_lead_ms_;
+
+  uint32_t bus_time_us() const;
+  void send_time_sync();
+  void stamp_execute_time(std::vector<uint8_t>& payload, uint32_t execute_at_us) const;
+
   bool create_isotp_socket(uint32_t node_id);
   int sockfd_;
   std::string can_interface_;
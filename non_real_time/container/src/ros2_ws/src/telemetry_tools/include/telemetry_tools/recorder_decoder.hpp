@@ -0,0 +1,93 @@
+#pragma once
+
+// Rebuilds a leg's flight recorder dump (FLIGHT_RECORDER, see
+// flight_recorder.hpp in the firmware) from its chunks. Chunks arrive either
+// as USB frames (decode with FrameDecoder) or as ISO-TP messages on the leg's
+// CAN transmit id 0x180 + leg (reassemble with IsoTpReassembler, e.g. from a
+// `candump -L` log).
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace telemetry_tools
+{
+
+constexpr uint8_t kRecorderCommand = 0x23;
+constexpr uint8_t kRecorderOpData = 0x04;
+constexpr size_t kRecorderChunkHeader = 10;
+constexpr uint32_t kLegTxBaseId = 0x180;
+
+struct FlightRecorderSample
+{
+  uint32_t timestamp_us;
+  float pos[3];
+  float vel[3];
+  float target[3];
+  float duty[3];
+  float disturbance[3];
+  float toe;
+};
+static_assert(sizeof(FlightRecorderSample) == 68, "must match the firmware's FlightRecorderSample");
+
+struct RecorderChunk
+{
+  uint8_t reason = 0;
+  uint16_t total = 0;
+  uint16_t first = 0;
+  uint16_t trigger_index = 0;
+  std::vector<FlightRecorderSample> samples;
+};
+
+// Parse a dump chunk payload. Returns false for anything that is not one.
+bool parse_recorder_chunk(const uint8_t * payload, size_t len, RecorderChunk & chunk);
+
+// Collects the chunks of one recording; a chunk of a different recording starts over
+class RecorderAssembler
+{
+public:
+  void add(const RecorderChunk & chunk);
+
+  size_t received() const {return received_;}
+  size_t total() const {return samples_.size();}
+  uint8_t reason() const {return reason_;}
+
+  // One row per received sample, t_ms relative to the trigger sample
+  void write_csv(std::ostream & out) const;
+
+private:
+  std::vector<FlightRecorderSample> samples_;
+  std::vector<bool> present_;
+  size_t received_ = 0;
+  uint16_t trigger_index_ = 0;
+  uint8_t reason_ = 0;
+};
+
+// ISO-TP receive side for the frames of one CAN id, no flow control
+class IsoTpReassembler
+{
+public:
+  using PayloadCallback = std::function<void (const uint8_t * payload, size_t len)>;
+
+  explicit IsoTpReassembler(PayloadCallback on_payload);
+
+  void feed(const uint8_t * data, size_t len);
+
+  uint64_t errors() const {return errors_;}
+
+private:
+  PayloadCallback on_payload_;
+  std::vector<uint8_t> buffer_;
+  size_t expected_ = 0;
+  uint8_t next_sequence_ = 0;
+  bool active_ = false;
+  uint64_t errors_ = 0;
+};
+
+// Parse one `candump -L` line: "(timestamp) iface ID#DATA". Returns false for anything else.
+bool parse_candump_line(const std::string & line, uint32_t & can_id, std::vector<uint8_t> & data);
+
+}  // namespace telemetry_tools
@@ -0,0 +1,110 @@
+#pragma once
+
+// Decoder for the leg firmware's binary serial output
+// (TELEMETRY_LOGGING_SPACE_BINARY and the flight recorder's USB dump, see
+// telemetry_frame.hpp in the firmware).
+//
+// Frames are COBS-encoded (payload + CRC-16/CCITT-FALSE) between 0x00
+// delimiters. TelemetryRecord below must match the firmware's layout; the
+// version byte and the frame length are checked for every frame.
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <vector>
+
+namespace telemetry_tools
+{
+
+constexpr uint8_t kRecordVersion = 1;
+constexpr size_t kMaxPayloadSize = 256;
+
+struct TelemetryRecord
+{
+  uint8_t version;
+  uint8_t leg;
+  uint16_t sequence;
+  uint32_t timestamp_us;
+  float joint_pos[3];
+  float joint_vel[3];
+  float joint_acc[3];
+  float tracking_error[3];
+  float duty[3];
+  float cartesian_pos[3];
+  float voltage;
+  float toe;
+};
+static_assert(sizeof(TelemetryRecord) == 88, "must match the firmware's TelemetryRecord");
+
+struct FrameStats
+{
+  uint64_t frames = 0;            // CRC-checked payloads delivered
+  uint64_t crc_errors = 0;
+  uint64_t malformed = 0;         // bad COBS or too long (also text between frames)
+};
+
+struct DecoderStats
+{
+  uint64_t records = 0;           // valid telemetry records delivered
+  uint64_t other_frames = 0;      // valid frames that are not telemetry records
+  uint64_t bad_records = 0;       // telemetry-sized frames with the wrong version
+  uint64_t dropped_records = 0;   // sequence numbers skipped, per leg
+};
+
+uint16_t crc16(const uint8_t * data, size_t len);
+
+// Decode one COBS frame without its delimiters. Returns false on a malformed frame.
+bool cobs_decode(const uint8_t * data, size_t len, std::vector<uint8_t> & out);
+
+// Splits a byte stream into CRC-checked frame payloads
+class FrameDecoder
+{
+public:
+  using PayloadCallback = std::function<void (const uint8_t * payload, size_t len)>;
+
+  explicit FrameDecoder(PayloadCallback on_payload);
+
+  // Feed raw serial bytes in any chunking; on_payload runs for every valid frame
+  void feed(const uint8_t * data, size_t len);
+
+  const FrameStats & stats() const {return stats_;}
+
+private:
+  void decode_frame();
+
+  PayloadCallback on_payload_;
+  std::vector<uint8_t> frame_;
+  std::vector<uint8_t> decoded_;
+  bool overflow_ = false;
+  FrameStats stats_;
+};
+
+class TelemetryDecoder
+{
+public:
+  using RecordCallback = std::function<void (const TelemetryRecord &)>;
+
+  explicit TelemetryDecoder(RecordCallback on_record);
+  TelemetryDecoder(const TelemetryDecoder &) = delete;
+  TelemetryDecoder & operator=(const TelemetryDecoder &) = delete;
+
+  void feed(const uint8_t * data, size_t len) {frames_.feed(data, len);}
+
+  const DecoderStats & stats() const {return stats_;}
+  const FrameStats & frame_stats() const {return frames_.stats();}
+
+private:
+  void handle_payload(const uint8_t * payload, size_t len);
+
+  RecordCallback on_record_;
+  FrameDecoder frames_;
+  std::array<int32_t, 256> last_sequence_;
+  DecoderStats stats_;
+};
+
+void write_csv_header(std::ostream & out);
+void write_csv_row(std::ostream & out, const TelemetryRecord & record);
+
+}  // namespace telemetry_tools
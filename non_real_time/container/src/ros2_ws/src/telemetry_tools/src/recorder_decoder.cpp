@@ -0,0 +1,156 @@
+#include "telemetry_tools/recorder_decoder.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <sstream>
+#include <utility>
+
+namespace telemetry_tools
+{
+
+bool parse_recorder_chunk(const uint8_t * payload, size_t len, RecorderChunk & chunk)
+{
+  if (len < kRecorderChunkHeader || payload[0] != kRecorderCommand || payload[1] != kRecorderOpData) {
+    return false;
+  }
+  uint8_t count = payload[3];
+  if (len != kRecorderChunkHeader + count * sizeof(FlightRecorderSample)) {
+    return false;
+  }
+  chunk.reason = payload[2];
+  std::memcpy(&chunk.total, &payload[4], sizeof(uint16_t));
+  std::memcpy(&chunk.first, &payload[6], sizeof(uint16_t));
+  std::memcpy(&chunk.trigger_index, &payload[8], sizeof(uint16_t));
+  if (chunk.first + count > chunk.total) {
+    return false;
+  }
+  chunk.samples.resize(count);
+  std::memcpy(chunk.samples.data(), &payload[kRecorderChunkHeader], count * sizeof(FlightRecorderSample));
+  return true;
+}
+
+void RecorderAssembler::add(const RecorderChunk & chunk)
+{
+  if (chunk.total != samples_.size() || chunk.trigger_index != trigger_index_ || chunk.reason != reason_) {
+    samples_.assign(chunk.total, FlightRecorderSample{});
+    present_.assign(chunk.total, false);
+    received_ = 0;
+    trigger_index_ = chunk.trigger_index;
+    reason_ = chunk.reason;
+  }
+  for (size_t i = 0; i < chunk.samples.size(); i++) {
+    size_t index = chunk.first + i;
+    if (!present_[index]) {
+      present_[index] = true;
+      received_++;
+    }
+    samples_[index] = chunk.samples[i];
+  }
+}
+
+void RecorderAssembler::write_csv(std::ostream & out) const
+{
+  out << "index,t_ms,timestamp_us";
+  const char * joint_fields[] = {"pos", "vel", "target", "duty", "dist"};
+  for (const char * field : joint_fields) {
+    for (int i = 0; i < 3; i++) {
+      out << ",j" << i << "_" << field;
+    }
+  }
+  out << ",toe,trigger\n";
+
+  uint32_t trigger_us = trigger_index_ < samples_.size() ? samples_[trigger_index_].timestamp_us : 0;
+  for (size_t index = 0; index < samples_.size(); index++) {
+    if (!present_[index]) {
+      continue;
+    }
+    const FlightRecorderSample & sample = samples_[index];
+    // wrapping difference, the recording is far shorter than the 71 minute micros() period
+    int32_t since_trigger_us = static_cast<int32_t>(sample.timestamp_us - trigger_us);
+    out << index << ',' << since_trigger_us / 1000.0 << ',' << sample.timestamp_us;
+    const float * values[] = {sample.pos, sample.vel, sample.target, sample.duty, sample.disturbance};
+    for (const float * field : values) {
+      for (int i = 0; i < 3; i++) {
+        out << ',' << field[i];
+      }
+    }
+    out << ',' << sample.toe << ',' << (index == trigger_index_ ? 1 : 0) << '\n';
+  }
+}
+
+IsoTpReassembler::IsoTpReassembler(PayloadCallback on_payload)
+: on_payload_(std::move(on_payload))
+{
+}
+
+void IsoTpReassembler::feed(const uint8_t * data, size_t len)
+{
+  if (len == 0) {
+    return;
+  }
+  uint8_t type = data[0] >> 4;
+  if (type == 0x0) {
+    size_t size = data[0] & 0x0F;
+    if (size + 1 <= len) {
+      on_payload_(&data[1], size);
+    } else {
+      errors_++;
+    }
+    active_ = false;
+  } else if (type == 0x1 && len == 8) {
+    if (active_) {
+      errors_++;
+    }
+    expected_ = (static_cast<size_t>(data[0] & 0x0F) << 8) | data[1];
+    buffer_.assign(&data[2], &data[8]);
+    next_sequence_ = 1;
+    active_ = true;
+  } else if (type == 0x2 && active_) {
+    if ((data[0] & 0x0F) != next_sequence_) {
+      errors_++;
+      active_ = false;
+      return;
+    }
+    next_sequence_ = (next_sequence_ + 1) & 0x0F;
+    size_t copy = std::min(len - 1, expected_ - buffer_.size());
+    buffer_.insert(buffer_.end(), &data[1], &data[1] + copy);
+    if (buffer_.size() >= expected_) {
+      active_ = false;
+      on_payload_(buffer_.data(), buffer_.size());
+    }
+  }
+}
+
+bool parse_candump_line(const std::string & line, uint32_t & can_id, std::vector<uint8_t> & data)
+{
+  std::istringstream fields(line);
+  std::string timestamp, interface, frame;
+  if (!(fields >> timestamp >> interface >> frame) || timestamp.empty() || timestamp[0] != '(') {
+    return false;
+  }
+  size_t hash = frame.find('#');
+  if (hash == std::string::npos || hash == 0) {
+    return false;
+  }
+  try {
+    can_id = static_cast<uint32_t>(std::stoul(frame.substr(0, hash), nullptr, 16));
+  } catch (const std::exception &) {
+    return false;
+  }
+  std::string hex = frame.substr(hash + 1);
+  if (hex.size() % 2 != 0 || hex.size() > 16) {
+    return false;
+  }
+  data.clear();
+  for (size_t i = 0; i < hex.size(); i += 2) {
+    try {
+      data.push_back(static_cast<uint8_t>(std::stoul(hex.substr(i, 2), nullptr, 16)));
+    } catch (const std::exception &) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace telemetry_tools
@@ -0,0 +1,105 @@
+// Rebuild a leg's flight recorder dump as CSV.
+//
+//   recorder_to_csv serial <capture.bin|-> [out.csv|-]
+//       raw USB capture taken while sending 'd' to the leg
+//   recorder_to_csv candump <log|-> <leg> [out.csv|-]
+//       `candump -L` log taken while sending CMD_FLIGHT_RECORDER op 0x03
+//
+// t_ms is relative to the trigger sample, marked with trigger = 1. Samples
+// missing from the capture are left out and counted on stderr.
+
+#include "telemetry_tools/recorder_decoder.hpp"
+#include "telemetry_tools/telemetry_decoder.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+
+namespace
+{
+
+int usage(const char * name)
+{
+  std::cerr << "usage: " << name << " serial <capture.bin|-> [out.csv|-]\n" <<
+    "       " << name << " candump <log|-> <leg> [out.csv|-]\n";
+  return 2;
+}
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  if (argc < 3) {
+    return usage(argv[0]);
+  }
+  bool serial = std::strcmp(argv[1], "serial") == 0;
+  bool candump = std::strcmp(argv[1], "candump") == 0;
+  if ((!serial && !candump) || (serial && argc > 4) || (candump && (argc < 4 || argc > 5))) {
+    return usage(argv[0]);
+  }
+  const char * out_path = argc > (serial ? 3 : 4) ? argv[serial ? 3 : 4] : "-";
+
+  std::ifstream in_file;
+  std::istream * in = &std::cin;
+  if (std::strcmp(argv[2], "-") != 0) {
+    in_file.open(argv[2], serial ? std::ios::binary : std::ios::in);
+    if (!in_file) {
+      std::cerr << "cannot open " << argv[2] << "\n";
+      return 1;
+    }
+    in = &in_file;
+  }
+
+  telemetry_tools::RecorderAssembler assembler;
+  uint64_t chunks = 0;
+  auto on_payload = [&](const uint8_t * payload, size_t len) {
+      telemetry_tools::RecorderChunk chunk;
+      if (telemetry_tools::parse_recorder_chunk(payload, len, chunk)) {
+        assembler.add(chunk);
+        chunks++;
+      }
+    };
+
+  uint64_t transport_errors = 0;
+  if (serial) {
+    telemetry_tools::FrameDecoder decoder(on_payload);
+    char buffer[4096];
+    while (in->read(buffer, sizeof(buffer)) || in->gcount() > 0) {
+      decoder.feed(reinterpret_cast<const uint8_t *>(buffer), static_cast<size_t>(in->gcount()));
+    }
+    transport_errors = decoder.stats().crc_errors;
+  } else {
+    uint32_t leg_id = telemetry_tools::kLegTxBaseId + static_cast<uint32_t>(std::stoul(argv[3]));
+    telemetry_tools::IsoTpReassembler reassembler(on_payload);
+    std::string line;
+    uint32_t can_id = 0;
+    std::vector<uint8_t> data;
+    while (std::getline(*in, line)) {
+      if (telemetry_tools::parse_candump_line(line, can_id, data) && can_id == leg_id) {
+        reassembler.feed(data.data(), data.size());
+      }
+    }
+    transport_errors = reassembler.errors();
+  }
+
+  std::ofstream out_file;
+  std::ostream * out = &std::cout;
+  if (std::strcmp(out_path, "-") != 0) {
+    out_file.open(out_path);
+    if (!out_file) {
+      std::cerr << "cannot open " << out_path << "\n";
+      return 1;
+    }
+    out = &out_file;
+  }
+  out->precision(std::numeric_limits<float>::max_digits10);
+  assembler.write_csv(*out);
+
+  std::cerr << "chunks " << chunks <<
+    ", samples " << assembler.received() << " of " << assembler.total() <<
+    ", trigger reason " << static_cast<int>(assembler.reason()) <<
+    ", transport errors " << transport_errors << "\n";
+  return assembler.received() == 0 ? 1 : 0;
+}
@@ -0,0 +1,144 @@
+#include "telemetry_tools/telemetry_decoder.hpp"
+
+#include <cstring>
+#include <utility>
+
+namespace telemetry_tools
+{
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "records are decoded in place, little endian only");
+
+// Largest payload + CRC with COBS overhead; anything longer between delimiters is not a frame
+static constexpr size_t kMaxFrameSize = kMaxPayloadSize + 2 + (kMaxPayloadSize + 2) / 254 + 1;
+
+uint16_t crc16(const uint8_t * data, size_t len)
+{
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= static_cast<uint16_t>(data[i]) << 8;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+    }
+  }
+  return crc;
+}
+
+bool cobs_decode(const uint8_t * data, size_t len, std::vector<uint8_t> & out)
+{
+  out.clear();
+  size_t i = 0;
+  while (i < len) {
+    uint8_t code = data[i++];
+    if (code == 0 || i + code - 1 > len) {
+      return false;
+    }
+    out.insert(out.end(), data + i, data + i + code - 1);
+    i += code - 1;
+    if (code != 0xFF && i < len) {
+      out.push_back(0);
+    }
+  }
+  return true;
+}
+
+FrameDecoder::FrameDecoder(PayloadCallback on_payload)
+: on_payload_(std::move(on_payload))
+{
+  frame_.reserve(kMaxFrameSize);
+}
+
+void FrameDecoder::feed(const uint8_t * data, size_t len)
+{
+  for (size_t i = 0; i < len; i++) {
+    if (data[i] != 0) {
+      if (frame_.size() < kMaxFrameSize) {
+        frame_.push_back(data[i]);
+      } else {
+        overflow_ = true;
+      }
+      continue;
+    }
+    if (overflow_) {
+      stats_.malformed++;
+    } else if (!frame_.empty()) {
+      decode_frame();
+    }
+    frame_.clear();
+    overflow_ = false;
+  }
+}
+
+void FrameDecoder::decode_frame()
+{
+  if (!cobs_decode(frame_.data(), frame_.size(), decoded_) || decoded_.size() < 3) {
+    stats_.malformed++;
+    return;
+  }
+  size_t len = decoded_.size() - 2;
+  uint16_t crc = decoded_[len] | (static_cast<uint16_t>(decoded_[len + 1]) << 8);
+  if (crc16(decoded_.data(), len) != crc) {
+    stats_.crc_errors++;
+    return;
+  }
+  stats_.frames++;
+  on_payload_(decoded_.data(), len);
+}
+
+TelemetryDecoder::TelemetryDecoder(RecordCallback on_record)
+: on_record_(std::move(on_record)),
+  frames_([this](const uint8_t * payload, size_t len) {handle_payload(payload, len);})
+{
+  last_sequence_.fill(-1);
+}
+
+void TelemetryDecoder::handle_payload(const uint8_t * payload, size_t len)
+{
+  if (len != sizeof(TelemetryRecord)) {
+    stats_.other_frames++;
+    return;
+  }
+  TelemetryRecord record;
+  std::memcpy(&record, payload, sizeof(record));
+  if (record.version != kRecordVersion) {
+    stats_.bad_records++;
+    return;
+  }
+
+  int32_t & last = last_sequence_[record.leg];
+  if (last >= 0) {
+    stats_.dropped_records += static_cast<uint16_t>(record.sequence - last - 1);
+  }
+  last = record.sequence;
+  stats_.records++;
+  on_record_(record);
+}
+
+void write_csv_header(std::ostream & out)
+{
+  out << "leg,sequence,timestamp_us";
+  const char * joint_fields[] = {"pos", "vel", "acc", "err", "duty"};
+  for (const char * field : joint_fields) {
+    for (int i = 0; i < 3; i++) {
+      out << ",j" << i << "_" << field;
+    }
+  }
+  out << ",x,y,z,voltage,toe\n";
+}
+
+void write_csv_row(std::ostream & out, const TelemetryRecord & record)
+{
+  out << static_cast<int>(record.leg) << ',' << record.sequence << ',' << record.timestamp_us;
+  const float * joint_fields[] = {
+    record.joint_pos, record.joint_vel, record.joint_acc, record.tracking_error, record.duty};
+  for (const float * field : joint_fields) {
+    for (int i = 0; i < 3; i++) {
+      out << ',' << field[i];
+    }
+  }
+  for (int i = 0; i < 3; i++) {
+    out << ',' << record.cartesian_pos[i];
+  }
+  out << ',' << record.voltage << ',' << record.toe << '\n';
+}
+
+}  // namespace telemetry_tools
@@ -0,0 +1,66 @@
+// Convert a raw serial capture of binary leg telemetry to CSV.
+//
+//   telemetry_to_csv [capture.bin|-] [out.csv|-]
+//
+// Input and output default to stdin and stdout, so a live port can be piped
+// through as well:  cat /dev/ttyACM0 | telemetry_to_csv - live.csv
+// Decoder statistics are printed to stderr at the end.
+
+#include "telemetry_tools/telemetry_decoder.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+int main(int argc, char ** argv)
+{
+  if (argc > 3 || (argc > 1 && std::strcmp(argv[1], "-h") == 0)) {
+    std::cerr << "usage: " << argv[0] << " [capture.bin|-] [out.csv|-]\n";
+    return 2;
+  }
+
+  std::ifstream in_file;
+  std::istream * in = &std::cin;
+  if (argc > 1 && std::strcmp(argv[1], "-") != 0) {
+    in_file.open(argv[1], std::ios::binary);
+    if (!in_file) {
+      std::cerr << "cannot open " << argv[1] << "\n";
+      return 1;
+    }
+    in = &in_file;
+  }
+
+  std::ofstream out_file;
+  std::ostream * out = &std::cout;
+  if (argc > 2 && std::strcmp(argv[2], "-") != 0) {
+    out_file.open(argv[2]);
+    if (!out_file) {
+      std::cerr << "cannot open " << argv[2] << "\n";
+      return 1;
+    }
+    out = &out_file;
+  }
+
+  out->precision(std::numeric_limits<float>::max_digits10);
+  telemetry_tools::write_csv_header(*out);
+  telemetry_tools::TelemetryDecoder decoder(
+    [out](const telemetry_tools::TelemetryRecord & record) {
+      telemetry_tools::write_csv_row(*out, record);
+    });
+
+  char buffer[4096];
+  while (in->read(buffer, sizeof(buffer)) || in->gcount() > 0) {
+    decoder.feed(reinterpret_cast<const uint8_t *>(buffer), static_cast<size_t>(in->gcount()));
+  }
+
+  const telemetry_tools::DecoderStats & stats = decoder.stats();
+  const telemetry_tools::FrameStats & frames = decoder.frame_stats();
+  std::cerr << "records " << stats.records <<
+    ", dropped " << stats.dropped_records <<
+    ", bad version " << stats.bad_records <<
+    ", other frames " << stats.other_frames <<
+    ", crc errors " << frames.crc_errors <<
+    ", malformed " << frames.malformed << "\n";
+  return 0;
+}
@@ -6,12 +6,66 @@
 //set to true to enable calibration routine for toe sensor. use LOG_LEVEL 2
 #define CALIBRATING_TOE false 
 
-// Telemetry logging mode: choose Cartesian or joint-space values in serial telemetry output
+// Telemetry logging mode: choose Cartesian or joint-space JSON in serial telemetry output,
+// or BINARY for COBS-framed records of both at a higher rate (decode with telemetry_tools)
 #define TELEMETRY_LOGGING_SPACE_NONE      0
 #define TELEMETRY_LOGGING_SPACE_CARTESIAN 1
 #define TELEMETRY_LOGGING_SPACE_JOINT     2
+#define TELEMETRY_LOGGING_SPACE_BINARY    3
 #define TELEMETRY_LOGGING_SPACE           2
 
+// Slowest encoder read rate for a settled axis; moving axes are read faster
+#define AXIS_ENCODER_MIN_RATE_HZ 100
+
+// Run the old finite-difference velocity filter next to the tracking observer and
+// time how far it lags ('v' on serial); also adds its velocity to joint telemetry
+#define AXIS_OBSERVER_BENCH false
+
+// Run the read-compute-write control cycle from a hardware alarm interrupt at
+// LEG_CONTROL_INTERVAL_US instead of as a scheduler task ('j' on serial for jitter)
+#define LEG_CONTROL_ISR false
+
+// Build the PID_v1 vs. AxisPID cycle-count comparison ('p' on serial)
+#define AXIS_PID_BENCH false
+
+// Add inverse-dynamics torque (inertia, friction, back-EMF) for the trajectory's
+// velocity and acceleration to the duty command ('t' on serial for tracking error)
+#define AXIS_MODEL_FEEDFORWARD false
+
+// Build the RP2040_PWM vs. PwmDriver cycle-count comparison ('w' on serial, stops the leg)
+#define PWM_DRIVER_BENCH false
+
+// Kinematics and trajectory math in double instead of float (scalar.hpp)
+#define HEX3_DOUBLE_PRECISION false
+
+// Polynomial trig and VSQRT for the leg kinematics instead of libm (kinematics_math.hpp)
+#define KINEMATICS_FAST_MATH false
+
+// Count cycles in inverse kinematics and linearMovePerform ('k' on serial)
+#define LEG_KINEMATICS_BENCH false
+
+// Time loop() sections with the cycle counter: min/mean/max and percentiles per
+// section ('l' on serial, CMD_LOOP_PROFILE over CAN); nothing is built when false
+#define LOOP_PROFILER false
+
+// Record every control cycle into a RAM ring that freezes around a trigger ('r' on serial
+// or CMD_FLIGHT_RECORDER over CAN) and can be dumped over USB ('d') or CAN (~68 kB of RAM)
+#define FLIGHT_RECORDER false
+
+// Follow RAPID setpoints along a Catmull-Rom spline at the control rate instead of
+// stepping to each one; the leg trails the host by RAPID_INTERPOLATION_DELAY_US
+#define RAPID_INTERPOLATION false
+#define RAPID_INTERPOLATION_DELAY_US 20000
+
+// Limits of the S-curve profile of linear moves (mm/s^2, mm/s^3); lower jerk is gentler
+// on the legs, acceleration then takes longer to build up
+#define MAX_LINEAR_ACCELERATION 500.0f
+#define MAX_LINEAR_JERK 20000.0f
+
+// Queued linear moves round each corner within this many mm instead of stopping there,
+// 0 stops at every corner
+#define LINEAR_BLEND_TOLERANCE 2.0f
+
 #define USER
 
 #endif
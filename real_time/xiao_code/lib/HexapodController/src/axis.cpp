@@ -16,10 +16,11 @@
 #include <math.h>
 #include "axis.hpp"
 #include "mux.hpp"
-#include <RP2040_PWM.h>
-
-/// PWM frequency for motor control signals
-#define PWM_FREQUENCY 50000 // Hz
+#include "pwm_driver.hpp"
+#if AXIS_PID_BENCH
+    #include <PID_v1.h>
+    #include "cycle_counter.hpp"
+#endif
 
 /**
  * @brief Map a value from one range to another
@@ -38,6 +39,19 @@ float float_map(float x, float in_min, float in_max, float out_min, float out_ma
     return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
 }
 
+/**
+ * @brief Wrap an angle difference to [-pi, pi] (shortest path)
+ */
+static float wrapAngle(float angle) {
+    if (angle > static_cast<float>(M_PI)) {
+        angle -= 2.0f * static_cast<float>(M_PI);
+    }
+    if (angle < -static_cast<float>(M_PI)) {
+        angle += 2.0f * static_cast<float>(M_PI);
+    }
+    return angle;
+}
+
 /**
  * @brief Constructor - Initialize axis with null/default values
  *
@@ -50,8 +64,6 @@ Axis::Axis() :
     _pin_c(0),
     _pin_d(0),
     _4_pin(false),
-    _pid_pos(nullptr),
-    _pid_vel(nullptr),
     _allowed_to_move(true)
 {}
 
@@ -59,22 +71,22 @@ Axis::Axis() :
  * @brief Link axis to 2-pin PWM motor
  *
  * Configures a simple 2-pin motor: one pin for forward PWM, one for reverse PWM.
- * Creates RP2040_PWM instances for hardware PWM generation.
+ * The pins are handed to the leg's PwmDriver, which sets up their slices once.
  *
  * @param pin_a PWM pin for forward direction
  * @param pin_b PWM pin for reverse direction
  * @param encoder_ch Multiplexer channel for encoder (0-7)
  * @param mux_ref Reference to the I2C multiplexer
+ * @param pwm_ref PWM driver shared by the axes of the leg
  *
  * @note Call after constructor and before initializeAxes()
  */
-void Axis::link(uint8_t pin_a, uint8_t pin_b, uint8_t encoder_ch, Mux& mux_ref) {
+void Axis::link(uint8_t pin_a, uint8_t pin_b, uint8_t encoder_ch, Mux& mux_ref, PwmDriver& pwm_ref) {
     _pin_a = pin_a;
     _pin_b = pin_b;
-    _pwm_instances[0] = new RP2040_PWM(_pin_a, PWM_FREQUENCY, 0);
-    _pwm_instances[1] = new RP2040_PWM(_pin_b, PWM_FREQUENCY, 0);
     _encoder_ch = encoder_ch;
     _mux = &mux_ref;
+    _pwm = &pwm_ref;
     _initializeAxis();
 }
 
@@ -90,28 +102,26 @@ void Axis::link(uint8_t pin_a, uint8_t pin_b, uint8_t encoder_ch, Mux& mux_ref)
  * @param pin_d PWM for motor 2 reverse
  * @param encoder_ch Multiplexer channel for encoder (0-7)
  * @param mux_ref Reference to the I2C multiplexer
+ * @param pwm_ref PWM driver shared by the axes of the leg
  *
  * @note Call after constructor and before initializeAxes()
  */
-void Axis::link(uint8_t pin_a, uint8_t pin_b, uint8_t pin_c, uint8_t pin_d, uint8_t encoder_ch, Mux& mux_ref) {
+void Axis::link(uint8_t pin_a, uint8_t pin_b, uint8_t pin_c, uint8_t pin_d, uint8_t encoder_ch, Mux& mux_ref, PwmDriver& pwm_ref) {
     _pin_a = pin_a;
     _pin_b = pin_b;
     _pin_c = pin_c;
     _pin_d = pin_d;
-    _pwm_instances[0] = new RP2040_PWM(_pin_a, PWM_FREQUENCY, 0);
-    _pwm_instances[1] = new RP2040_PWM(_pin_b, PWM_FREQUENCY, 0);
-    _pwm_instances[2] = new RP2040_PWM(_pin_c, PWM_FREQUENCY, 0);
-    _pwm_instances[3] = new RP2040_PWM(_pin_d, PWM_FREQUENCY, 0);
     _encoder_ch = encoder_ch;
     _mux = &mux_ref;
+    _pwm = &pwm_ref;
     _initializeAxis();
 }
 
 /**
- * @brief Initialize GPIO pins to OUTPUT and drive low
+ * @brief Drive the pins low, then hand them to the PWM driver at 0 % duty
  *
- * Sets all motor control pins as outputs and ensures they start in safe (no-drive) state.
- * Automatically detects 4-pin vs 2-pin configuration.
+ * Automatically detects 4-pin vs 2-pin configuration. The outputs stay low
+ * until the leg starts the driver and the first levels are latched.
  */
 void Axis::_initializeAxis() {
     pinMode(_pin_a, OUTPUT);
@@ -127,6 +137,13 @@ void Axis::_initializeAxis() {
         digitalWrite(_pin_c, LOW);
         digitalWrite(_pin_d, LOW);  
     }
+
+    _pwm_channels[0] = _pwm->addPin(_pin_a);
+    _pwm_channels[1] = _pwm->addPin(_pin_b);
+    if (_4_pin) {
+        _pwm_channels[2] = _pwm->addPin(_pin_c);
+        _pwm_channels[3] = _pwm->addPin(_pin_d);
+    }
 }
     
 /**
@@ -158,8 +175,7 @@ float Axis::getCurrentPos() {
 /**
  * @brief Get current velocity estimate (filtered)
  *
- * Returns smoothed velocity calculated from position derivatives.
- * Uses low-pass filter (0.1 new + 0.9 old) to reduce noise.
+ * Returns the tracking observer's velocity as of the last encoder sample.
  *
  * @return Velocity in rad/s
  */
@@ -170,8 +186,8 @@ float Axis::getCurrentVelocity() {
 /**
  * @brief Get current acceleration estimate
  *
- * Acceleration is calculated as the rate of change of velocity.
- * Generally noisy - useful for diagnostics but not for control.
+ * Acceleration state of the tracking observer.
+ * Noisier than velocity - useful for diagnostics and feedforward, not for feedback.
  *
  * @return Acceleration in rad/s^2
  */
@@ -180,30 +196,41 @@ float Axis::getCurrentAcceleration() {
 }
 
 /**
- * @brief Private method to read current position from encoder via multiplexer
+ * @brief Private method to convert a raw encoder angle into axis position
  *
- * Performs I2C read from encoder through multiplexer channel, then normalizes
- * angle to [-π, π] range and applies zero offset calibration.
+ * Normalizes the angle to [-π, π] range after applying the zero offset calibration.
  *
- * @return Position in radians, normalized to [-pi, pi], or NAN if read fails
- * @note This is a blocking call (~1-3ms) due to I2C communication
+ * @param encoder_reading Raw encoder angle in radians
+ * @return Position in radians, normalized to [-pi, pi], or NAN if the reading is NAN
  */
-float Axis::_getCurrentPos() {
-    if (_mux == nullptr){
-        return NAN;
-    }  
-    float encoder_reading = _mux->readEncoder(_encoder_ch);
+float Axis::_encoderToPos(float encoder_reading) {
     if (isnan(encoder_reading)) {
         return NAN;
     }
-    encoder_reading -= _zero_pos;
-    if (encoder_reading > M_PI) {
-        encoder_reading -= 2.0 * M_PI;
-    }
-    if (encoder_reading < -M_PI) {
-        encoder_reading += 2.0 * M_PI;
+    return wrapAngle(encoder_reading - _zero_pos);
+}
+
+/**
+ * @brief Encoder read period this axis wants from the sensing core
+ *
+ * Scales linearly with how much the axis is doing: the larger of measured
+ * velocity, commanded velocity and position error, each relative to its
+ * AXIS_SAMPLE_FULL_RATE_* threshold. A settled or disabled axis drops to
+ * AXIS_SAMPLE_PERIOD_MAX_US and leaves its bus slots to the joints that move.
+ *
+ * @return Period in microseconds, AXIS_SAMPLE_PERIOD_MIN_US..AXIS_SAMPLE_PERIOD_MAX_US
+ */
+uint32_t Axis::getSamplePeriodUs() {
+    if (!_allowed_to_move) {
+        return AXIS_SAMPLE_PERIOD_MAX_US;
     }
-    return encoder_reading;
+    float error = isnan(_target_pos) ? 0.0f : fabs(_target_pos - _current_pos);
+    float demand = fabs(_current_velocity) / AXIS_SAMPLE_FULL_RATE_VELOCITY;
+    // the velocity setpoint already holds Kv_ff times the trajectory velocity, so take the larger, not the sum
+    demand = fmaxf(demand, fmaxf(fabs(_target_velocity), fabs(_feedforward_velocity)) / AXIS_SAMPLE_FULL_RATE_VELOCITY);
+    demand = fmaxf(demand, error / AXIS_SAMPLE_FULL_RATE_ERROR);
+    demand = constrain(demand, 0.0f, 1.0f);
+    return AXIS_SAMPLE_PERIOD_MAX_US - static_cast<uint32_t>(demand * (AXIS_SAMPLE_PERIOD_MAX_US - AXIS_SAMPLE_PERIOD_MIN_US));
 }
 
 /**
@@ -221,51 +248,148 @@ bool Axis::targetPosReached() {
 /**
  * @brief Main tracking update loop for position, velocity, and disturbance estimation
  *
- * **Must be called regularly (1-10 ms)** Performs two independent time-triggered updates:
+ * **Must be called regularly (1-10 ms)** with this axis' entry of the latest
+ * sensor snapshot. Pure computation - the encoder is read on the sensing core.
  *
- * **Position Phase** (interval = AXIS_POSITION_TRACK_INTERVAL_MS):
- * - Reads encoder via I2C (blocking ~1-3ms)
- * - Updates current position
+ * Everything runs once per new encoder sample (sequence number moved on):
+ * - Updates current position from the encoder sample
+ * - Runs the tracking observer for velocity and acceleration (see _updateObserver())
  * - Estimates motor current and torque
- * - Runs momentum observer for disturbance detection
  *
- * **Velocity Phase** (interval = AXIS_VELOCITY_TRACK_INTERVAL_MS):
- * - Calculates velocity from position change
- * - Low-pass filters: v_new = 0.1*raw + 0.9*v_old
- * - Calculates acceleration as dv/dt
- * - Handles angle wrapping (shortest path)
+ * With AXIS_OBSERVER_BENCH the previous fixed-interval estimator also runs, for comparison.
  *
- * Separate update rates balance computational load with control responsiveness.
+ * @param sample Latest encoder sample for this axis
  */
-void Axis::trackMotion() {
-    
-    if (millis() - _last_pos_update_time > AXIS_POSITION_TRACK_INTERVAL_MS) {
-        uint32_t delta_time = millis() - _last_pos_update_time;
-        uint32_t temp_last_update_time = millis();
-        float current_pos = _getCurrentPos();
-        if (isnan(current_pos)) {
-            return;
+void Axis::trackMotion(const EncoderSample& sample) {
+    if (sample.sequence != 0 && sample.sequence != _last_sample_sequence) {
+        _last_sample_sequence = sample.sequence;
+        float current_pos = _encoderToPos(sample.angle);
+        if (!isnan(current_pos)) {
+            _current_pos = current_pos;
+            _updateObserver(current_pos, sample.timestamp_us);
+            _updateMotorCurrentEstimate();
         }
-        _last_pos_update_time = temp_last_update_time; //avoid time skew due to I2C delay
-        _current_pos = current_pos;
-        _updateMotorCurrentEstimate();
-        momentumMonitor();
     }
+#if AXIS_OBSERVER_BENCH
+    _updateLegacyVelocity();
+#endif
+}
+
+/**
+ * @brief Alpha-beta-gamma tracking observer for position, velocity and acceleration
+ *
+ * Predicts the state forward to the sample's own read timestamp, then corrects
+ * it with the wrapped residual. Gains come from a critically damped
+ * fading-memory filter with discount factor AXIS_OBSERVER_THETA:
+ *   alpha = 1 - theta^3, beta = 1.5 (1 - theta^2)(1 - theta), gamma = 0.5 (1 - theta)^3
+ *
+ * Using the measured read time instead of the loop time keeps the velocity
+ * honest when reads are late or the sample period changes. The state is reset
+ * on the first sample and after a gap longer than AXIS_OBSERVER_RESET_US.
+ *
+ * @param measured_pos Axis position from the encoder (rad)
+ * @param timestamp_us micros() when the encoder read completed
+ */
+void Axis::_updateObserver(float measured_pos, uint32_t timestamp_us) {
+    uint32_t elapsed_us = timestamp_us - _observer_last_us;
+    if (!_observer_initialized || elapsed_us > AXIS_OBSERVER_RESET_US) {
+        _observer_pos = measured_pos;
+        _current_velocity = 0.0f;
+        _current_acceleration = 0.0f;
+        _observer_last_us = timestamp_us;
+        _observer_initialized = true;
+        return;
+    }
+    if (elapsed_us == 0) {
+        return;
+    }
+    _observer_last_us = timestamp_us;
+
+    const float theta = AXIS_OBSERVER_THETA;
+    const float alpha = 1.0f - theta * theta * theta;
+    const float beta = 1.5f * (1.0f - theta * theta) * (1.0f - theta);
+    const float gamma = 0.5f * (1.0f - theta) * (1.0f - theta) * (1.0f - theta);
+
+    float dt = elapsed_us / 1000000.0f;
+    float predicted_pos = _observer_pos + _current_velocity * dt + 0.5f * _current_acceleration * dt * dt;
+    float predicted_vel = _current_velocity + _current_acceleration * dt;
+    float residual = wrapAngle(measured_pos - wrapAngle(predicted_pos));
+
+    _observer_pos = wrapAngle(predicted_pos + alpha * residual);
+    _current_velocity = predicted_vel + beta * residual / dt;
+    _current_acceleration += 2.0f * gamma * residual / (dt * dt);
+}
+
+#if AXIS_OBSERVER_BENCH
+/**
+ * @brief Previous velocity estimator, kept only to compare against the observer
+ *
+ * millis()-interval finite difference with a 0.1/0.9 low-pass. Also times
+ * direction reversals of both estimators: the legacy reversal trailing the
+ * observer's one is the extra lag the observer removed.
+ */
+void Axis::_updateLegacyVelocity() {
     if (millis() - _last_vel_update_time > AXIS_VELOCITY_TRACK_INTERVAL_MS) {
         uint32_t delta_time = millis() - _last_vel_update_time;
-        _last_velocity = getCurrentVelocity();
-
-        float distance_traversed = getCurrentPos() - _last_position;
-        distance_traversed += (distance_traversed > M_PI) ? -2 * M_PI : (distance_traversed < -M_PI) ? 2 * M_PI : 0; // Assume shortest path
-        _current_velocity = distance_traversed / (static_cast<float>(delta_time) / 1000.0); //rad/s
-        _current_velocity = (0.1 * _current_velocity) + (0.9 * _last_velocity); // low-pass filter to reduce noise
-        _current_acceleration = (getCurrentVelocity() - _last_velocity) / (static_cast<float>(delta_time) / 1000.0); //rad/s^2
+        float last_velocity = _legacy_velocity;
+        float distance_traversed = wrapAngle(getCurrentPos() - _last_position);
+        _legacy_velocity = distance_traversed / (static_cast<float>(delta_time) / 1000.0f); //rad/s
+        _legacy_velocity = (0.1f * _legacy_velocity) + (0.9f * last_velocity); // low-pass filter to reduce noise
         _last_position = getCurrentPos();
         _last_vel_update_time = millis();
-       
+    }
+
+    uint32_t now = micros();
+    int8_t observer_sign = _observer_sign;
+    if (_current_velocity > AXIS_OBSERVER_BENCH_HYSTERESIS) {
+        observer_sign = 1;
+    }
+    else if (_current_velocity < -AXIS_OBSERVER_BENCH_HYSTERESIS) {
+        observer_sign = -1;
+    }
+    if (observer_sign != _observer_sign) {
+        _observer_sign = observer_sign;
+        _observer_reversal_us = now;
+    }
+
+    int8_t legacy_sign = _legacy_sign;
+    if (_legacy_velocity > AXIS_OBSERVER_BENCH_HYSTERESIS) {
+        legacy_sign = 1;
+    }
+    else if (_legacy_velocity < -AXIS_OBSERVER_BENCH_HYSTERESIS) {
+        legacy_sign = -1;
+    }
+    if (legacy_sign != _legacy_sign) {
+        _legacy_sign = legacy_sign;
+        uint32_t lag_us = now - _observer_reversal_us;
+        if (legacy_sign == _observer_sign && _observer_reversal_us != 0 && lag_us < AXIS_OBSERVER_BENCH_MAX_LAG_US) {
+            _bench_lag_sum_us += lag_us;
+            if (lag_us > _bench_lag_max_us) {
+                _bench_lag_max_us = lag_us;
+            }
+            _bench_reversals++;
+        }
     }
 }
 
+/**
+ * @brief Lag of the previous estimator behind the observer, measured at direction reversals
+ *
+ * @param[out] reversals Number of matched reversals
+ * @param[out] mean_lag_us Mean delay of the legacy reversal after the observer's
+ * @param[out] max_lag_us Worst delay
+ */
+void Axis::getObserverBench(uint32_t& reversals, uint32_t& mean_lag_us, uint32_t& max_lag_us) {
+    reversals = _bench_reversals;
+    mean_lag_us = _bench_reversals ? _bench_lag_sum_us / _bench_reversals : 0;
+    max_lag_us = _bench_lag_max_us;
+}
+
+float Axis::getLegacyVelocity() {
+    return _legacy_velocity;
+}
+#endif
+
 /**
  * @brief Convert desired torque to PWM duty cycle
  *
@@ -280,10 +404,33 @@ void Axis::trackMotion() {
  */
 float Axis::_torqueToDutyCycle(float torque) {
     float target_current = torque / _torque_constant; // I = T / Kt
-    float target_duty = (target_current * _resistance + _current_velocity * _back_EMF_constant) / getInputVoltage() * 100.0;
+    float target_duty = (target_current * _resistance + _current_velocity * _back_EMF_constant) / getInputVoltage() * 100.0f;
     return target_duty;
 }
 
+/**
+ * @brief Duty cycle from the motor model with inverse-dynamics feedforward
+ *
+ * tau = tau_pid + J * alpha_d + tau_friction * sign(omega_d)
+ * V = (tau / Kt) * R + omega_d * Ke
+ *
+ * omega_d is the trajectory velocity (_feedforward_velocity), not the velocity
+ * loop's setpoint, so position error stays with the velocity loop and back-EMF
+ * leads the motion instead of following the observer. Without a commanded
+ * velocity (holding) the friction sign comes from the feedback torque.
+ *
+ * @param feedback_torque Velocity loop output in Nm
+ * @return Duty cycle (-100..100 before limiting)
+ */
+float Axis::_inverseDynamicsDuty(float feedback_torque) {
+    float velocity = _feedforward_velocity;
+    float direction = velocity != 0.0f ? velocity : feedback_torque;
+    float torque = feedback_torque + _total_inertia * _feedforward_acceleration
+                 + _getEstimatedFriction() * (direction >= 0.0f ? 1.0f : -1.0f);
+    float current = torque / _torque_constant; // I = T / Kt
+    return (current * _resistance + velocity * _back_EMF_constant) / getInputVoltage() * 100.0f;
+}
+
 /**
  * @brief Estimate friction force (feedforward compensation)
  *
@@ -308,11 +455,11 @@ float Axis::_getEstimatedFriction() {
  * Note: Doubles current estimate if 4-pin (dual motor) configuration.
  */
 void Axis::_updateMotorCurrentEstimate() {
-    _estimated_current = ((getDutyCycle() / 100.0 * getInputVoltage()) - _current_velocity * _back_EMF_constant) / _resistance; 
+    _estimated_current = ((getDutyCycle() / 100.0f * getInputVoltage()) - _current_velocity * _back_EMF_constant) / _resistance; 
     if (_4_pin) {
         _estimated_current *= 2; // if using 4-pin control, there are two motors so we can double the current (and thus torque) 
     }
-    _estimated_torque = _estimated_torque * 0.8 + (_estimated_current * _torque_constant * 0.2) * -1.0; // very rough estimate, assumes linear relationship between duty cycle and voltage, and that torque is proportional to current
+    _estimated_torque = _estimated_torque * 0.8f + (_estimated_current * _torque_constant * 0.2f) * -1.0f; // very rough estimate, assumes linear relationship between duty cycle and voltage, and that torque is proportional to current
 }
 
 /**
@@ -325,9 +472,9 @@ void Axis::_updateMotorCurrentEstimate() {
  * - Anti-windup limits disturbance estimate magnitude
  *
  * This is useful for detecting collisions or external forces.
- * Called by trackMotion() automatically.
  *
- * **Update Rate:** MOMENTUM_MONITOR_INTERVAL_MS
+ * **Update Rate:** MOMENTUM_MONITOR_INTERVAL_MS, run as a leg scheduler task.
+ * dt is still measured, so a late run integrates the time that actually passed.
  */
 void Axis::momentumMonitor() {
 
@@ -342,9 +489,6 @@ void Axis::momentumMonitor() {
     }
 
     uint32_t elapsed_ms = now - _last_momentum_monitor_update_time;
-    if (elapsed_ms < MOMENTUM_MONITOR_INTERVAL_MS) {
-        return;
-    }
 
     // Clip dt to a safe range to prevent numerical issues after long pauses or scheduling jitter
     float dt = (elapsed_ms / 1000.0f);
@@ -447,6 +591,62 @@ uint8_t Axis::setFeedforwardVelocity(float velocity) {
     return 0;
 }
 
+/**
+ * @brief Set the joint acceleration the trajectory expects at the current setpoint
+ *
+ * Used by the inverse-dynamics feedforward (AXIS_MODEL_FEEDFORWARD) as the
+ * inertia term, _total_inertia * acceleration.
+ *
+ * @param acceleration Feedforward acceleration in rad/s^2
+ * @return Always 0 (success)
+ */
+uint8_t Axis::setFeedforwardAcceleration(float acceleration) {
+    _feedforward_acceleration = acceleration;
+    return 0;
+}
+
+/**
+ * @brief Accumulate tracking error statistics for a control step
+ *
+ * Only counts while a trajectory is feeding the axis. Dividing the error by the
+ * commanded velocity gives how far behind the trajectory the axis runs in time,
+ * the lag feedforward is meant to remove.
+ */
+void Axis::_recordTrackingError(float error) {
+    _tracking_error = error;
+    if (_feedforward_velocity == 0.0f) {
+        return;
+    }
+    float magnitude = fabs(error);
+    _tracking.samples++;
+    _tracking.error_sq_sum += error * error;
+    if (magnitude > _tracking.error_max) {
+        _tracking.error_max = magnitude;
+    }
+    if (fabs(_feedforward_velocity) > AXIS_TRACKING_MIN_VELOCITY) {
+        _tracking.lag_samples++;
+        _tracking.lag_sum_s += error / _feedforward_velocity;
+    }
+}
+
+/// Position setpoint (rad), NAN until one is set
+float Axis::getTargetPos() {
+    return _target_pos;
+}
+
+/// Target minus measured position at the last control step (rad)
+float Axis::getTrackingError() {
+    return _tracking_error;
+}
+
+TrackingStats Axis::getTrackingStats() {
+    return _tracking;
+}
+
+void Axis::resetTrackingStats() {
+    _tracking = TrackingStats();
+}
+
 /**
  * @brief Internal method to generate PWM signals to motor driver
  *
@@ -462,34 +662,35 @@ uint8_t Axis::setFeedforwardVelocity(float velocity) {
  * - Reverse: pin_a=duty_cycle, pin_b=0%, pin_c=duty_cycle, pin_d=0%
  *
  * Applies axis reversal logic if _reverse_axis flag is set (inverts direction).
- * PWM frequency is fixed at PWM_FREQUENCY (50kHz).
+ * PWM frequency is fixed at PWM_FREQUENCY (50kHz). Levels are only staged in
+ * the PwmDriver; the leg latches all axes together after its control step.
  *
  * @param dir Desired rotation direction (true=forward, false=reverse)
  * @param duty_cycle Desired PWM duty cycle in range [0.0, 80.0] (constrained)
  * @return Always 0 (success)
  */
 uint8_t Axis::_setDutyCycle(bool dir, float duty_cycle) {
-    float max_duty_cycle = 80.0;
-    _duty_cycle = constrain(duty_cycle, 0.0, max_duty_cycle);
+    float max_duty_cycle = 80.0f;
+    _duty_cycle = constrain(duty_cycle, 0.0f, max_duty_cycle);
     _dir = dir;
     
     if (_reverse_axis) {
         _dir = !_dir;
     }
     if (_dir) {
-        _pwm_instances[0]->setPWM(_pin_a, PWM_FREQUENCY, 0.0);
-        _pwm_instances[1]->setPWM(_pin_b, PWM_FREQUENCY, _duty_cycle);
+        _pwm->setLevel(_pwm_channels[0], 0.0f);
+        _pwm->setLevel(_pwm_channels[1], _duty_cycle);
         if (_4_pin) {
-            _pwm_instances[2]->setPWM(_pin_c, PWM_FREQUENCY, 0.0);
-            _pwm_instances[3]->setPWM(_pin_d, PWM_FREQUENCY, _duty_cycle);
+            _pwm->setLevel(_pwm_channels[2], 0.0f);
+            _pwm->setLevel(_pwm_channels[3], _duty_cycle);
         }
     } 
     else {
-        _pwm_instances[0]->setPWM(_pin_a, PWM_FREQUENCY, _duty_cycle);
-        _pwm_instances[1]->setPWM(_pin_b, PWM_FREQUENCY, 0.0);
+        _pwm->setLevel(_pwm_channels[0], _duty_cycle);
+        _pwm->setLevel(_pwm_channels[1], 0.0f);
         if (_4_pin) {
-            _pwm_instances[2]->setPWM(_pin_c, PWM_FREQUENCY, _duty_cycle);
-            _pwm_instances[3]->setPWM(_pin_d, PWM_FREQUENCY, 0.0);
+            _pwm->setLevel(_pwm_channels[2], _duty_cycle);
+            _pwm->setLevel(_pwm_channels[3], 0.0f);
         }
     }
     return 0;
@@ -498,29 +699,24 @@ uint8_t Axis::_setDutyCycle(bool dir, float duty_cycle) {
 
 void Axis::setControlConstants(float Kp_pos, float Kd_pos, float Kp_vel, float Ki_vel, float Kv_ff) {
     _Kp_pos = Kp_pos;
-    _Ki_pos = 0.0; // not currently using integral control for position, as it can lead to instability and overshoot. may add back later with some anti-windup logic
+    _Ki_pos = 0.0f; // not currently using integral control for position, as it can lead to instability and overshoot. may add back later with some anti-windup logic
     _Kd_pos = Kd_pos;
     _Kp_vel = Kp_vel;
     _Ki_vel = Ki_vel;
-    _Kd_vel = 0.0; // not currently using derivative control for velocity, as it can amplify noise. may add back later with some filtering
+    _Kd_vel = 0.0f; // not currently using derivative control for velocity, as it can amplify noise. may add back later with some filtering
     _Kv_ff = Kv_ff;
-    if (_pid_pos != nullptr) {
-        delete _pid_pos;
-    }
-    _pid_pos = new PID(&_current_pos, &_pos_control, &_target_pos, _Kp_pos, _Ki_pos, _Kd_pos, DIRECT);
-    _pid_pos->SetOutputLimits(-_max_speed, _max_speed); // Output is target velocity in rad/s
-    _pid_pos->SetSampleTime(1);
+
+    _pid_pos.setGains(_Kp_pos, _Ki_pos, _Kd_pos);
+    _pid_pos.setOutputLimits(-_max_speed, _max_speed); // Output is target velocity in rad/s
+    _pid_pos.setDerivativeFilter(AXIS_POS_DERIVATIVE_TAU_S);
+    _pid_pos.reset();
     Serial.printf("Axis Position PID set: Kp=%f, Ki=%f, Kd=%f\n", _Kp_pos, _Ki_pos, _Kd_pos);
-    _pid_pos->SetMode(AUTOMATIC);
-    
-    if (_pid_vel != nullptr) {
-        delete _pid_vel;
-    }
-    _pid_vel = new PID(&_current_velocity, &_vel_control, &_target_velocity, _Kp_vel, _Ki_vel, _Kd_vel, DIRECT);
-    _pid_vel->SetOutputLimits(-20.0, 20.0); // Output is target torque in Nm TODO make configurable and configure to the real torque limits of the system
-    _pid_vel->SetSampleTime(AXIS_VELOCITY_TRACK_INTERVAL_MS);
+
+    _pid_vel.setGains(_Kp_vel, _Ki_vel, _Kd_vel);
+    _pid_vel.setOutputLimits(-AXIS_VEL_OUTPUT_LIMIT, AXIS_VEL_OUTPUT_LIMIT); // Output is target torque in Nm
+    _pid_vel.reset();
     Serial.printf("Axis Velocity PID set: Kp=%f, Ki=%f, Kd=%f\n", _Kp_vel, _Ki_vel, _Kd_vel);
-    _pid_vel->SetMode(AUTOMATIC);
+    _control_constants_set = true;
 }
 
 
@@ -531,6 +727,15 @@ void Axis::allowMotion(bool allowed) {
     }
 }
 
+/**
+ * @brief One step of the cascaded position -> velocity -> torque controller
+ *
+ * dt is the measured time since the previous step; after a gap longer than
+ * AXIS_CONTROL_MAX_DT_S (first step, motion re-enabled) both loops restart
+ * from the current state instead of integrating the gap.
+ *
+ * @return 0 on success, 255 if motion is not allowed, 254 if no target or no gains set
+ */
 uint8_t Axis::moveToPos() {
     if (_allowed_to_move == false) {
         return 255; // move not allowed
@@ -538,41 +743,57 @@ uint8_t Axis::moveToPos() {
     if (isnan(_target_pos)) {
         return 254; // no target position set
     }
-    if (_pid_pos == nullptr) {
+    if (!_control_constants_set) {
         Serial.println("Error: PID not initialized for Axis");
         return 254; // PID not initialized
     }
 
+    uint32_t now = micros();
+    float dt = (now - _last_control_us) / 1000000.0f;
+    _last_control_us = now;
+    if (dt > AXIS_CONTROL_MAX_DT_S) {
+        _pid_pos.reset();
+        _pid_vel.reset();
+        dt = 0.0f; // proportional only this step
+    }
+
     float error = _target_pos - _current_pos;
+    _recordTrackingError(error);
     float accepted_error = AXIS_POSITION_TOLERANCE;
+#if AXIS_MODEL_FEEDFORWARD
+    // the deadband would cut the model torque out mid-trajectory, only hold still when not being fed
+    if (fabs(error) <= accepted_error && _feedforward_velocity == 0.0f) {
+#else
     if (fabs(error) <= accepted_error) {
-        _setDutyCycle(0, 0.0);
+#endif
+        _setDutyCycle(0, 0.0f);
         return 0;
     }
-    _pid_pos->Compute();
+    _pos_control = _pid_pos.compute(_target_pos, _current_pos, dt);
     
     _setTargetVelocity(_pos_control + (_Kv_ff * _feedforward_velocity));
-    _moveAtVelocity();
+    _moveAtVelocity(dt);
     return 0;
 }
 
-uint8_t Axis::_moveAtVelocity() {
+uint8_t Axis::_moveAtVelocity(float dt) {
     if (_allowed_to_move == false) {
         return 255; // move not allowed
     }
     if (isnan(_target_velocity)) {
         return 254; // no target velocity set
     }
-    if (_pid_vel == nullptr) {
-        Serial.println("Error: PID not initialized for Axis");
-        return 254; // PID not initialized
-    }
-    _pid_vel->Compute();
+    _vel_control = _pid_vel.compute(_target_velocity, _current_velocity, dt);
+
+#if AXIS_MODEL_FEEDFORWARD
+    // Model terms carry the trajectory, the velocity PID only corrects what is left
+    float control = _inverseDynamicsDuty(_vel_control);
+#else
+    float control = _torqueToDutyCycle(_vel_control + _getEstimatedFriction() * (_vel_control >= 0 ? 1.0f : -1.0f));
+#endif
 
-    float control = _torqueToDutyCycle(_vel_control + _getEstimatedFriction() * (_vel_control >= 0 ? 1.0 : -1.0));
-                    
-    float duty_cycle = constrain(control, -100.0, 100.0);
-    _setDutyCycle(duty_cycle >= 0.0, fabs(duty_cycle));
+    float duty_cycle = constrain(control, -100.0f, 100.0f);
+    _setDutyCycle(duty_cycle >= 0.0f, fabs(duty_cycle));
     return 0;
 }
 
@@ -584,6 +805,7 @@ uint8_t Axis::moveToPosAtSpeed(float pos, float target_speed) {
 
 void Axis::stopAxis() {
     _setDutyCycle(false, 0);
+    _pwm->latch(); // do not wait for the next control step
 }
 
 _Bool Axis::setMapping(float zero_pos, float map_mult, _Bool reverse_axis) {
@@ -594,11 +816,11 @@ _Bool Axis::setMapping(float zero_pos, float map_mult, _Bool reverse_axis) {
 }
 
 float Axis::_radsToDegrees(float rads) {
-    return rads * 180.0 / M_PI;
+    return rads * 180.0f / static_cast<float>(M_PI);
 }
 
 float Axis::_degreesToRads(float degrees) {
-    return degrees * M_PI / 180.0;
+    return degrees * static_cast<float>(M_PI) / 180.0f;
 }
 
 _Bool Axis::setMaxPos(float max_pos) {
@@ -633,14 +855,14 @@ float Axis::getDutyCycle() {
 
 float Axis::getCorrectedDutyCycle() {
     float real_duty = getDutyCycle();
-    if (real_duty > 0.01) {
-        return float_map(real_duty, _min_duty, 100.0, 0.0, 100.0);
+    if (real_duty > 0.01f) {
+        return float_map(real_duty, _min_duty, 100.0f, 0.0f, 100.0f);
     }
-    else if (real_duty < -0.01) {
-        return float_map(real_duty, -100.0, -_min_duty, -100.0, 0.0);
+    else if (real_duty < -0.01f) {
+        return float_map(real_duty, -100.0f, -_min_duty, -100.0f, 0.0f);
     }
     else {
-        return 0.0;
+        return 0.0f;
     }
 }
 
@@ -653,4 +875,134 @@ float Axis::getMaxPos() {
 }
 float Axis::getMinPos() {
     return _min_pos;
-}
\ No newline at end of file
+}
+
+uint8_t Axis::getEncoderChannel() {
+    return _encoder_ch;
+}
+void AxisPID::setGains(float kp, float ki, float kd) {
+    _kp = kp;
+    _ki = ki;
+    _kd = kd;
+}
+
+void AxisPID::setOutputLimits(float min_output, float max_output) {
+    _min_output = min_output;
+    _max_output = max_output;
+    _integral = constrain(_integral, _min_output, _max_output);
+}
+
+/// @param tau_s Derivative low-pass time constant, 0 for no filtering
+void AxisPID::setDerivativeFilter(float tau_s) {
+    _tau = tau_s;
+}
+
+/// Clear integral and derivative history; the next compute() has no derivative term
+void AxisPID::reset() {
+    _integral = 0.0f;
+    _derivative = 0.0f;
+    _primed = false;
+}
+
+/**
+ * @brief One controller update
+ *
+ * @param setpoint Desired value
+ * @param measurement Measured value
+ * @param dt Time since the previous update (s), must be > 0
+ * @param feedforward Added to the output before saturation
+ * @return Output clamped to the output limits
+ */
+float AxisPID::compute(float setpoint, float measurement, float dt, float feedforward) {
+    float error = setpoint - measurement;
+
+    if (_primed && dt > 0.0f) {
+        float raw_derivative = -(measurement - _last_measurement) / dt;
+        _derivative += (dt / (_tau + dt)) * (raw_derivative - _derivative);
+    }
+    _last_measurement = measurement;
+    _primed = true;
+
+    float integral = _integral + _ki * error * dt;
+    float output = _kp * error + integral + _kd * _derivative + feedforward;
+    if (output > _max_output) {
+        output = _max_output;
+        if (error > 0.0f) {
+            integral = _integral; // saturated high and still pushing up - hold the integral
+        }
+    }
+    else if (output < _min_output) {
+        output = _min_output;
+        if (error < 0.0f) {
+            integral = _integral;
+        }
+    }
+    _integral = constrain(integral, _min_output, _max_output);
+    return output;
+}
+
+#if AXIS_PID_BENCH
+/**
+ * @brief Cycle counts of one cascaded controller step, PID_v1 (double) vs AxisPID (float)
+ *
+ * Runs both on the same synthetic position/velocity trace with the axis' usual
+ * gains and limits and prints min/mean/max cycles per step. PID_v1 gates itself
+ * on millis(), so only calls that actually computed are counted for it.
+ */
+void Axis::benchmarkController() {
+    const uint16_t steps = 200;
+    cycleCounterBegin();
+
+    double input_pos = 0.0, output_pos = 0.0, setpoint_pos = 0.5;
+    double input_vel = 0.0, output_vel = 0.0, setpoint_vel = 0.0;
+    PID legacy_pos(&input_pos, &output_pos, &setpoint_pos, 20.0, 0.0, 0.015, DIRECT);
+    PID legacy_vel(&input_vel, &output_vel, &setpoint_vel, 3.0, 4.5, 0.0, DIRECT);
+    legacy_pos.SetOutputLimits(-10000.0, 10000.0);
+    legacy_vel.SetOutputLimits(-AXIS_VEL_OUTPUT_LIMIT, AXIS_VEL_OUTPUT_LIMIT);
+    legacy_pos.SetSampleTime(1);
+    legacy_vel.SetSampleTime(1);
+    legacy_pos.SetMode(AUTOMATIC);
+    legacy_vel.SetMode(AUTOMATIC);
+
+    AxisPID pos, vel;
+    pos.setGains(20.0f, 0.0f, 0.015f);
+    pos.setOutputLimits(-10000.0f, 10000.0f);
+    pos.setDerivativeFilter(AXIS_POS_DERIVATIVE_TAU_S);
+    vel.setGains(3.0f, 4.5f, 0.0f);
+    vel.setOutputLimits(-AXIS_VEL_OUTPUT_LIMIT, AXIS_VEL_OUTPUT_LIMIT);
+
+    uint32_t legacy_min = UINT32_MAX, legacy_max = 0, legacy_sum = 0, legacy_count = 0;
+    uint32_t float_min = UINT32_MAX, float_max = 0, float_sum = 0;
+    for (uint16_t i = 0; i < steps; i++) {
+        float position = 0.5f * sinf(i * 0.05f);
+        float velocity = 0.025f * cosf(i * 0.05f) * 1000.0f;
+        input_pos = position;
+        input_vel = velocity;
+        delay(1); // let PID_v1's sample time elapse
+
+        uint32_t start = cycleCount();
+        bool computed = legacy_pos.Compute();
+        setpoint_vel = output_pos;
+        computed = legacy_vel.Compute() && computed;
+        uint32_t cycles = cycleCount() - start;
+        if (computed) {
+            legacy_min = min(legacy_min, cycles);
+            legacy_max = max(legacy_max, cycles);
+            legacy_sum += cycles;
+            legacy_count++;
+        }
+
+        start = cycleCount();
+        float velocity_command = pos.compute(0.5f, position, 0.001f);
+        vel.compute(velocity_command, velocity, 0.001f);
+        cycles = cycleCount() - start;
+        float_min = min(float_min, cycles);
+        float_max = max(float_max, cycles);
+        float_sum += cycles;
+    }
+
+    Serial.printf("Controller step, %u steps: PID_v1 (double) computed %lu, cycles min %lu mean %lu max %lu | AxisPID (float) cycles min %lu mean %lu max %lu\n",
+        steps, legacy_count, legacy_count ? legacy_min : 0, legacy_count ? legacy_sum / legacy_count : 0, legacy_max,
+        float_min, float_sum / steps, float_max);
+}
+#endif
@@ -1,27 +1,92 @@
 #include <Arduino.h>
 #include <stdint.h>
 #include "mux.hpp"
-#include <RP2040_PWM.h>
-#include <PID_v1.h>
+#include "user_config.hpp"
+#include "pwm_driver.hpp"
 
 #ifndef HEX3_AXIS
 #define HEX3_AXIS
-    #define AXIS_POSITION_TRACK_INTERVAL_MS 3
-    #define AXIS_POSITION_TOLERANCE 0.001 //rads
-    #define AXIS_VELOCITY_TRACK_INTERVAL_MS 3
+    #define AXIS_POSITION_TOLERANCE 0.001f //rads
+    // Encoder sampling policy: the sensing core reads each encoder at a period the axis asks for,
+    // from AXIS_SAMPLE_PERIOD_MIN_US while moving down to AXIS_ENCODER_MIN_RATE_HZ once settled
+    #define AXIS_SAMPLE_PERIOD_MIN_US 2000
+    #ifndef AXIS_ENCODER_MIN_RATE_HZ
+        #define AXIS_ENCODER_MIN_RATE_HZ 100
+    #endif
+    #define AXIS_SAMPLE_PERIOD_MAX_US (1000000UL / AXIS_ENCODER_MIN_RATE_HZ)
+    #define AXIS_SAMPLE_FULL_RATE_VELOCITY 0.5f // rad/s, at or above this the axis gets the fastest period
+    #define AXIS_SAMPLE_FULL_RATE_ERROR (20 * AXIS_POSITION_TOLERANCE) // rad, same for tracking error
+    #define AXIS_VELOCITY_TRACK_INTERVAL_MS 3 // legacy estimator interval, AXIS_OBSERVER_BENCH only
+    #define AXIS_OBSERVER_THETA 0.6f // tracking observer discount factor per sample, lower = faster but noisier
+    #define AXIS_OBSERVER_RESET_US 50000 // restart the observer after a sample gap this long
+    #ifndef AXIS_OBSERVER_BENCH
+        #define AXIS_OBSERVER_BENCH false
+    #endif
+    #define AXIS_OBSERVER_BENCH_HYSTERESIS 0.05f // rad/s, velocity sign change threshold for reversal timing
+    #define AXIS_OBSERVER_BENCH_MAX_LAG_US 500000 // reversals further apart than this are not matched
     #define MOMENTUM_MONITOR_INTERVAL_MS 5
     #define DISTURBANCE_MONITOR_INTERVAL_MS 10
 
+    #define AXIS_POS_DERIVATIVE_TAU_S 0.002f // position loop derivative low-pass time constant (s)
+    #define AXIS_VEL_OUTPUT_LIMIT 20.0f // velocity loop output, Nm TODO make configurable and configure to the real torque limits of the system
+    #define AXIS_CONTROL_MAX_DT_S 0.05f // a longer gap between control steps restarts the controllers
+    #ifndef AXIS_PID_BENCH
+        #define AXIS_PID_BENCH false
+    #endif
+    #ifndef AXIS_MODEL_FEEDFORWARD
+        #define AXIS_MODEL_FEEDFORWARD false // add inverse-dynamics torque for the trajectory's velocity and acceleration
+    #endif
+    #define AXIS_TRACKING_MIN_VELOCITY 0.2f // rad/s, commanded speed above which tracking error is also read as lag
+
     //pindefs for use in leg.cpp
     //S1: 11 12;            ch 5 (?)
     //S2A: 18 2; S2B: 17 3; ch 6 (?)
     //S3: 16 15;            ch 7 (?)
 
+    /**
+     * @class AxisPID
+     * @brief Single-precision PID with explicit dt for the cascaded axis loops
+     *
+     * - Derivative on measurement, first-order filtered, so setpoint steps do not kick
+     * - Conditional integration: the integral is frozen while the output is saturated
+     *   in the direction the error pushes, and clamped to the output range
+     * - Optional feedforward added before saturation
+     */
+    class AxisPID {
+        public:
+            void setGains(float kp, float ki, float kd);
+            void setOutputLimits(float min_output, float max_output);
+            void setDerivativeFilter(float tau_s);
+            void reset();
+            float compute(float setpoint, float measurement, float dt, float feedforward = 0.0f);
+
+        private:
+            float _kp = 0.0f;
+            float _ki = 0.0f;
+            float _kd = 0.0f;
+            float _min_output = -1.0f;
+            float _max_output = 1.0f;
+            float _tau = 0.0f;
+            float _integral = 0.0f;
+            float _derivative = 0.0f;            ///< filtered -d(measurement)/dt
+            float _last_measurement = 0.0f;
+            bool _primed = false;                ///< _last_measurement valid
+    };
+
+    /// Position tracking error while a trajectory feeds the axis (feedforward velocity non-zero)
+    struct TrackingStats {
+        uint32_t samples = 0;
+        float error_sq_sum = 0.0f;          ///< rad^2
+        float error_max = 0.0f;             ///< rad, largest |error|
+        uint32_t lag_samples = 0;           ///< samples commanded faster than AXIS_TRACKING_MIN_VELOCITY
+        float lag_sum_s = 0.0f;             ///< error / commanded velocity, summed over lag_samples
+    };
+
     class Axis {
         public:
             Axis();
-            void link(uint8_t pin_a, uint8_t pin_b, uint8_t encoder_ch, Mux& mux_ref);
-            void link(uint8_t pin_a, uint8_t pin_b, uint8_t pin_c, uint8_t pin_d, uint8_t encoder_ch, Mux& mux_ref);
+            void link(uint8_t pin_a, uint8_t pin_b, uint8_t encoder_ch, Mux& mux_ref, PwmDriver& pwm_ref);
+            void link(uint8_t pin_a, uint8_t pin_b, uint8_t pin_c, uint8_t pin_d, uint8_t encoder_ch, Mux& mux_ref, PwmDriver& pwm_ref);
             void stopAxis();
             void initializePositionLimits(float min_pos, float max_pos);
             uint8_t moveToPos();
@@ -35,8 +100,11 @@
 			float getMaxSpeed();
 			float getMaxPos();
 			float getMinPos();
+			uint8_t getEncoderChannel();
+			uint32_t getSamplePeriodUs();
             uint8_t setTargetPos(float pos);
-            void trackMotion();
+            float getTargetPos();
+            void trackMotion(const EncoderSample& sample);
             float getCurrentVelocity();
             float getCurrentAcceleration();
             void allowMotion(bool allowed);
@@ -46,6 +114,13 @@
             float getCorrectedDutyCycle();
             float getEstimatedTorque();
             uint8_t setFeedforwardVelocity(float velocity);
+            uint8_t setFeedforwardAcceleration(float acceleration);
+            float getTrackingError();
+            TrackingStats getTrackingStats();
+            void resetTrackingStats();
+#if AXIS_PID_BENCH
+            static void benchmarkController();
+#endif
 
             // Experimental features for disturbance monitoring and compensation, not fully implemented yet
             void momentumMonitor();
@@ -53,14 +128,24 @@
             void setInputVoltage(float voltage);
             float getInputVoltage();
             float getMOBDisturbanceTorque();
+#if AXIS_OBSERVER_BENCH
+            float getLegacyVelocity();
+            void getObserverBench(uint32_t& reversals, uint32_t& mean_lag_us, uint32_t& max_lag_us);
+#endif
 
         private:
             void _updateMotorCurrentEstimate();
             float _torqueToDutyCycle(float torque);
             uint8_t _setDutyCycle(bool dir, float duty_cycle);
             uint8_t _setTargetVelocity(float velocity);
-            uint8_t _moveAtVelocity();
+            uint8_t _moveAtVelocity(float dt);
             float _getEstimatedFriction();
+            float _inverseDynamicsDuty(float feedback_torque);
+            void _recordTrackingError(float error);
+            void _updateObserver(float measured_pos, uint32_t timestamp_us);
+#if AXIS_OBSERVER_BENCH
+            void _updateLegacyVelocity();
+#endif
 
             bool _allowed_to_move = true;
             uint8_t _pin_a = 0;
@@ -69,17 +154,17 @@
             uint8_t _pin_d = 0;
             uint8_t _encoder_ch = 0;
             float _input_voltage = -1.0; //default to impossible number to indicate not set
-            double _Kp_pos;
-            double _Ki_pos;
-            double _Kd_pos;
-            double _Kp_vel;
-            double _Ki_vel;
-            double _Kd_vel;
-            double _Kv_ff = 0.0; //0.0 unless otherwise specified
+            float _Kp_pos;
+            float _Ki_pos;
+            float _Kd_pos;
+            float _Kp_vel;
+            float _Ki_vel;
+            float _Kd_vel;
+            float _Kv_ff = 0.0; //0.0 unless otherwise specified
             _Bool _4_pin = false;
-            double _target_pos = NAN;
-            double _target_velocity = 0.0;
-            double _target_acceleration = 0.0;
+            float _target_pos = NAN;
+            float _target_velocity = 0.0;
+            float _target_acceleration = 0.0;
             void _initializeAxis(); 
             Mux* _mux;
             float _max_speed = 10000;      //rad/s
@@ -89,7 +174,7 @@
 			float _map_mult;       //unitless
 			float _zero_pos;       //rad
 			uint64_t _next_go_time; //milliseconds
-			double _current_pos = 0.0; //rad
+			float _current_pos = 0.0; //rad
 			uint16_t _move_time = 0; //milliseconds
 			float _start_rads;
 			float _end_rads;
@@ -99,16 +184,29 @@
 			float _axisMap(float x);
 			float _radsToDegrees(float rads);
 			float _degreesToRads(float degrees);
-            RP2040_PWM* _pwm_instances[4]; //max 4 pins
-            float _getCurrentPos();
-            double _current_velocity = 0.0;
+            PwmDriver* _pwm = nullptr;
+            uint8_t _pwm_channels[4] = {PWM_DRIVER_NO_CHANNEL, PWM_DRIVER_NO_CHANNEL, PWM_DRIVER_NO_CHANNEL, PWM_DRIVER_NO_CHANNEL}; //max 4 pins
+            float _encoderToPos(float encoder_reading);
+            float _current_velocity = 0.0;
             float _current_acceleration = 0.0;
+            uint32_t _last_sample_sequence = 0;
+            bool _observer_initialized = false;
+            float _observer_pos = 0.0;          //rad, filtered position
+            uint32_t _observer_last_us = 0;     //timestamp of the last sample the observer took
+#if AXIS_OBSERVER_BENCH
+            float _legacy_velocity = 0.0;
             float _last_position = 0.0;
-            float _last_velocity = 0.0;
-            uint32_t _last_pos_update_time = 0;
             uint32_t _last_vel_update_time = 0;
-            double _pos_control = 0.0;
-            double _vel_control = 0.0;
+            int8_t _observer_sign = 0;
+            int8_t _legacy_sign = 0;
+            uint32_t _observer_reversal_us = 0;
+            uint32_t _bench_reversals = 0;
+            uint32_t _bench_lag_sum_us = 0;
+            uint32_t _bench_lag_max_us = 0;
+#endif
+            float _pos_control = 0.0;
+            float _vel_control = 0.0;
+            uint32_t _last_control_us = 0;      //micros() of the last controller update
             float _duty_cycle = 0;
             bool _dir = false;
             float _back_EMF_constant = 5.0; //V/(rad/s), rough estimate based on motor specs and gear ratio
@@ -117,11 +215,15 @@
             float _estimated_current = 0.0; // Amps
             float _estimated_torque = 0.0; //Nm
             float _min_duty = 52.5; //minimum duty cycle to overcome motor deadzone from standstill
-            PID* _pid_pos;
-            PID* _pid_vel;
+            AxisPID _pid_pos;
+            AxisPID _pid_vel;
+            bool _control_constants_set = false;
             float _feedforward_velocity = 0.0;
+            float _feedforward_acceleration = 0.0; //rad/s^2, from the trajectory
+            float _tracking_error = 0.0;        //rad, target minus measured at the last control step
+            TrackingStats _tracking;
 
-            float _total_inertia = 2.0; //kg*m^2, very rough estimate for now, will be used for disturbance monitoring and feedforward acceleration control once implemented
+            float _total_inertia = 2.0; //kg*m^2, very rough estimate for now, used for disturbance monitoring and the model feedforward
             float _MOB_disturbance_torque = 0.0; //momentum observer disturbance torque estimate
             float _DOB_disturbance_torque = 0.0; //disturbance observer disturbance torque estimate
 
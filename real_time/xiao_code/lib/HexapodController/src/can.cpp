@@ -1,7 +1,8 @@
 #include "can.hpp"
 #include "leg.hpp"
 #include "log_levels.hpp"
-#include <functional>
+#include "profiler.hpp"
+#include <hardware/clocks.h>
 
 /*
 CAN COMMAND FORMAT
@@ -21,6 +22,7 @@ Byte 1..2   int16 x (scaled by 10)
 Byte 3..4   int16 y (scaled by 10)
 Byte 5..6   int16 z (scaled by 10)
 Byte 7..8   int16 speed (scaled by 10)
+Byte 9..12  optional uint32 execute time
 
 Typically ISO-TP multi-frame
 
@@ -37,13 +39,19 @@ Single frame
 --------------------------------------------------
 CMD_QUADRATIC_MOVE (0x12)
 --------------------------------------------------
-Quadratic trajectory move
+Quadratic Bezier segment from wherever the leg is when it starts,
+followed at the control rate (see trajectory.hpp)
 
 Payload:
 Byte 0      -> command id
-Byte 1..n   -> trajectory params
+Byte 1      -> flags, bit 0: the control point is a point the curve
+               passes at half time instead of the Bezier control point
+Byte 2..7   -> 3 int16 control point x, y, z (scaled by 10)
+Byte 8..13  -> 3 int16 end point x, y, z (scaled by 10)
+Byte 14..15 -> uint16 duration (ms)
+Byte 16..19 -> optional uint32 execute time, the segment is timed from it
 
-Typically ISO-TP multi-frame
+Always ISO-TP multi-frame
 
 --------------------------------------------------
 CMD_SINGLE_AXIS_MOVE (0x13)
@@ -54,6 +62,7 @@ Payload:
 Byte 0      -> command id
 Byte 1      -> axis
 Byte 2..3   -> int16 position (scaled by 10)
+Byte 4..7   -> optional uint32 execute time
 
 Single frame
 
@@ -67,9 +76,33 @@ Byte 0      -> command id
 Byte 1..2   int16 x (scaled by 10)
 Byte 3..4   int16 y (scaled by 10)
 Byte 5..6   int16 z (scaled by 10)
+Byte 7..10  optional uint32 execute time
 
 Can be single or multi-frame
 
+Execute time (LINEAR, QUADRATIC, SINGLE_AXIS, RAPID):
+- bus time (see SYNC below) before which the command does not start,
+  see Leg::processCommandQueue()
+- a command always waits for the previous linear move or curve to finish (a
+  linear move may still blend into a linear move), timed or not; a timed
+  command reaching an idle leg starts exactly at its execute time
+- 0 or absent starts it once the previous move has finished
+- ignored, the command running untimed, until the leg has seen a SYNC frame
+  or if it lies more than COMMAND_MAX_LEAD_US either side of now
+- up to COMMAND_QUEUE_SIZE commands can be queued ahead
+- legs given the same execute time start together, to within the sync error
+
+--------------------------------------------------
+SYNC (CAN id 0x080, TIME_SYNC_CAN_ID)
+--------------------------------------------------
+Bus time broadcast, host -> all legs, about every 100 ms
+
+Raw CAN frame, not ISO-TP:
+Byte 0..3   -> uint32 host bus time (us)
+Byte 4      -> uint8 sequence, incremented per frame
+
+Each leg tracks offset and drift of its micros() against it (time_sync.hpp)
+
 --------------------------------------------------
 CMD_LEG_STATE (0x20)
 --------------------------------------------------
@@ -84,6 +117,99 @@ Always ISO-TP multi-frame
 
 Notes:
 - sent periodically from leg -> host
+
+--------------------------------------------------
+CMD_ENCODER_DIAG (0x21)
+--------------------------------------------------
+Encoder I/O diagnostics, on request
+
+Request (host -> leg), single frame:
+Byte 0      -> command id
+
+Response (leg -> host), ISO-TP multi-frame:
+Byte 0      -> command id
+Then 20 bytes per axis, axes 0..2:
+  Byte 0..1    uint16 failed transfers
+  Byte 2..3    uint16 reads with a magnet fault (AS5600 STATUS: MD clear, ML or MH set)
+  Byte 4..5    uint16 retries
+  Byte 6..7    uint16 mean transfer time (us)
+  Byte 8..9    uint16 max transfer time (us)
+  Byte 10..11  uint16 age of last good sample (ms), 0xFFFF if none
+  Byte 12..19  uint8 latency histogram, % of transfers per bucket
+               (bucket i: < 64us << i, last bucket open-ended)
+
+Counters saturate at 0xFFFF.
+
+--------------------------------------------------
+CMD_LOOP_PROFILE (0x22)
+--------------------------------------------------
+Loop section cycle profile, on request (LOOP_PROFILER builds only)
+
+Request (host -> leg), single frame:
+Byte 0      -> command id
+Byte 1      -> optional, nonzero restarts the counters after the reply
+
+Response (leg -> host), ISO-TP multi-frame:
+Byte 0      -> command id
+Byte 1      -> number of sections
+Byte 2..5   -> uint32 core clock (Hz)
+Then 28 bytes per section, in ProfileSection order (profiler.hpp):
+  Byte 0..3    uint32 samples
+  Byte 4..7    uint32 min cycles
+  Byte 8..11   uint32 mean cycles
+  Byte 12..15  uint32 max cycles
+  Byte 16..19  uint32 50th percentile cycles
+  Byte 20..23  uint32 90th percentile cycles
+  Byte 24..27  uint32 99th percentile cycles
+
+--------------------------------------------------
+CMD_FLIGHT_RECORDER (0x23)
+--------------------------------------------------
+Control-cycle flight recorder (FLIGHT_RECORDER builds only, see flight_recorder.hpp)
+
+Request (host -> leg):
+Byte 0      -> command id
+Byte 1      -> op
+               0x00 status
+               0x01 trigger now
+               0x02 arm: discard the recording and start over
+                    Byte 2     trigger mask, bit 0 disturbance, bit 1 command start
+                    Byte 3..4  int16 disturbance threshold (scaled by 1000), 0 = off
+               0x03 dump the frozen recording
+
+Status reply (leg -> host) to ops 0x00..0x02, and to 0x03 if not frozen:
+Byte 0      -> command id
+Byte 1      -> 0x00
+Byte 2      -> state: 0 recording, 1 taking post-trigger samples, 2 frozen
+Byte 3      -> trigger reason: 0 none, 1 manual, 2 disturbance, 3 command
+Byte 4..5   -> uint16 samples recorded
+Byte 6..7   -> uint16 index of the trigger sample
+Byte 8      -> trigger mask
+Byte 9..10  -> int16 disturbance threshold (scaled by 1000)
+
+Dump (leg -> host), one ISO-TP message every FLIGHT_RECORDER_CAN_CHUNK_INTERVAL_MS
+with op 0x04 and the chunk layout in flight_recorder.hpp.
+
+--------------------------------------------------
+CMD_TIME_SYNC (0x24)
+--------------------------------------------------
+Bus time sync error, on request
+
+Request (host -> leg), single frame:
+Byte 0      -> command id
+Byte 1      -> optional, nonzero restarts the max error after the reply
+
+Response (leg -> host), ISO-TP multi-frame:
+Byte 0      -> command id
+Byte 1      -> state: 0 no SYNC yet, 1 acquiring, 2 locked, 3 holdover
+Byte 2..5   -> int32 last measured error, bus time minus leg estimate (us)
+Byte 6..7   -> uint16 largest |error| since restarted (us)
+Byte 8..11  -> int32 drift of the leg clock (ppb), positive when slow
+Byte 12..13 -> uint16 SYNC frames received
+Byte 14..15 -> uint16 SYNC frames missed
+Byte 16..17 -> uint16 estimate restarts
+
+Counters saturate at 0xFFFF.
 */
 
 Can::Can(
@@ -121,6 +247,13 @@ bool Can::begin()
         Serial.printf("CAN tx/rx ready: 0x%X, 0x%X\n", _tx_node_id, _rx_node_id);
     #endif
 
+    _leg->scheduler.addTask("can_telem", [](void* can) { static_cast<Can*>(can)->sendLegTelemetry(); },
+        this, CAN_TELEMETRY_INTERVAL_MS * 1000, 4 * SCHEDULER_TICK_US, 4);
+#if FLIGHT_RECORDER
+    _leg->scheduler.addTask("rec_dump", [](void* can) { static_cast<Can*>(can)->sendRecorderChunk(); },
+        this, FLIGHT_RECORDER_CAN_CHUNK_INTERVAL_MS * 1000, 5 * SCHEDULER_TICK_US, 5);
+#endif
+
     return true;
 }
 
@@ -132,7 +265,11 @@ enum CommandSubtype : uint8_t
     CMD_SINGLE_AXIS_MOVE  = 0x13,
     CMD_RAPID_MOVE        = 0x14,
 
-    CMD_LEG_STATE         = 0x20
+    CMD_LEG_STATE         = 0x20,
+    CMD_ENCODER_DIAG      = 0x21,
+    CMD_LOOP_PROFILE      = 0x22,
+    CMD_FLIGHT_RECORDER   = FLIGHT_RECORDER_CAN_COMMAND,
+    CMD_TIME_SYNC         = TIME_SYNC_CAN_COMMAND
 };
 
 enum IsoTpFrameType : uint8_t
@@ -160,21 +297,46 @@ struct IsoTpRxBuffer
 static IsoTpRxBuffer _isotp_rx;
 
 static const uint32_t CMD_TIMEOUT_MS = 250;
-static const uint32_t TELEMETRY_INTERVAL_MS = 100;
 
-static uint32_t _last_telemetry_tx = 0;
 
 static float decodeScaledInt16(int16_t raw)
 {
     return static_cast<float>(raw) / 10.0f;
 }
 
+// Optional trailing execute time at offset as leg micros(), 0 (start when ready) if absent or unusable
+uint32_t Can::decodeExecuteTime(const uint8_t* d, uint16_t len, uint16_t offset)
+{
+    uint32_t bus_us = 0;
+    if (len >= offset + sizeof(uint32_t))
+    {
+        memcpy(&bus_us, &d[offset], sizeof(uint32_t));
+    }
+    if (bus_us == 0 || !time_sync.isValid())
+    {
+        return 0;
+    }
+    uint32_t execute_at_us = time_sync.toLocal(bus_us);
+    int32_t lead_us = static_cast<int32_t>(execute_at_us - micros());
+    if (lead_us > COMMAND_MAX_LEAD_US || lead_us < -COMMAND_MAX_LEAD_US)
+    {
+        #if LOG_LEVEL >= CAN_DEBUG
+            Serial.printf("CAN: Execute time %ld us from now, running untimed\n", lead_us);
+        #endif
+        return 0;
+    }
+    return execute_at_us != 0 ? execute_at_us : 1;
+}
+
 static int16_t encodeScaledInt16(float value)
 {
     return static_cast<int16_t>(value * 10.0f + (value >= 0.0f ? 0.5f : -0.5f));
 }
 
-static std::function<void()> _pending_command = nullptr;
+static uint16_t saturate16(uint32_t value)
+{
+    return value > 0xFFFF ? 0xFFFF : static_cast<uint16_t>(value);
+}
 
 bool Can::isFresh(uint32_t last)
 {
@@ -195,20 +357,6 @@ static void resetIsoTp()
     #endif
 }
 
-std::function<void()> Can::popPendingCommand()
-{
-    std::function<void()> fn = _pending_command;
-
-    _pending_command = nullptr;
-
-    return fn;
-}
-
-void Can::queueCommand(std::function<void()> fn)
-{
-    _pending_command = fn;
-}
-
 void Can::sendIsoTp(const uint8_t* data, uint16_t len)
 {
     if (len <= 7)
@@ -313,6 +461,124 @@ void Can::sendLegTelemetry()
     //#endif
 }
 
+void Can::sendEncoderDiagnostics()
+{
+    EncoderDiagnostics diagnostics;
+    if (!_leg->sensing.readDiagnostics(diagnostics))
+    {
+        return;
+    }
+
+    uint8_t payload[1 + NUM_AXES_PER_LEG * 20];
+    memset(payload, 0, sizeof(payload));
+    payload[0] = CMD_ENCODER_DIAG;
+
+    uint32_t now = micros();
+    for (uint8_t i = 0; i < NUM_AXES_PER_LEG; i++)
+    {
+        const EncoderStats& stats = diagnostics.encoders[i];
+        uint16_t fields[6] =
+        {
+            saturate16(stats.failures),
+            saturate16(stats.invalid),
+            saturate16(stats.retries),
+            saturate16(stats.reads ? static_cast<uint32_t>(stats.latency_sum_us / stats.reads) : 0),
+            saturate16(stats.latency_max_us),
+            stats.last_good_us ? saturate16((now - stats.last_good_us) / 1000) : static_cast<uint16_t>(0xFFFF)
+        };
+        uint8_t* entry = &payload[1 + i * 20];
+        memcpy(entry, fields, sizeof(fields));
+        for (uint8_t b = 0; b < ENCODER_LATENCY_BUCKETS; b++)
+        {
+            entry[12 + b] = stats.reads ? static_cast<uint8_t>((stats.latency_histogram[b] * 100ULL) / stats.reads) : 0;
+        }
+    }
+
+    sendIsoTp(payload, sizeof(payload));
+}
+
+void Can::sendTimeSyncStatus()
+{
+    uint8_t payload[18];
+    payload[0] = CMD_TIME_SYNC;
+    payload[1] = time_sync.getState();
+    int32_t error = time_sync.getLastError();
+    uint16_t max_error = saturate16(time_sync.getMaxError());
+    int32_t drift_ppb = static_cast<int32_t>(time_sync.getDrift() * 1e9f);
+    uint16_t counts[3] =
+    {
+        saturate16(time_sync.getSyncs()),
+        saturate16(time_sync.getMissed()),
+        saturate16(time_sync.getSteps())
+    };
+    memcpy(&payload[2], &error, sizeof(error));
+    memcpy(&payload[6], &max_error, sizeof(max_error));
+    memcpy(&payload[8], &drift_ppb, sizeof(drift_ppb));
+    memcpy(&payload[12], counts, sizeof(counts));
+    sendIsoTp(payload, sizeof(payload));
+}
+
+#if LOOP_PROFILER
+void Can::sendLoopProfile()
+{
+    uint8_t payload[6 + PROFILE_NUM_SECTIONS * 28];
+    payload[0] = CMD_LOOP_PROFILE;
+    payload[1] = PROFILE_NUM_SECTIONS;
+    uint32_t clock_hz = clock_get_hz(clk_sys);
+    memcpy(&payload[2], &clock_hz, sizeof(clock_hz));
+
+    for (uint8_t s = 0; s < PROFILE_NUM_SECTIONS; s++)
+    {
+        ProfileSummary summary;
+        Profiler::summarize(static_cast<ProfileSection>(s), summary);
+        uint32_t fields[7] =
+        {
+            summary.count,
+            summary.min,
+            summary.mean,
+            summary.max,
+            summary.p50,
+            summary.p90,
+            summary.p99
+        };
+        memcpy(&payload[6 + s * 28], fields, sizeof(fields));
+    }
+
+    sendIsoTp(payload, sizeof(payload));
+}
+#endif
+
+#if FLIGHT_RECORDER
+void Can::sendRecorderStatus()
+{
+    FlightRecorder& recorder = _leg->recorder;
+    uint8_t payload[11];
+    payload[0] = CMD_FLIGHT_RECORDER;
+    payload[1] = FLIGHT_RECORDER_OP_STATUS;
+    payload[2] = recorder.getState();
+    payload[3] = recorder.getReason();
+    uint16_t recorded = recorder.getRecorded();
+    uint16_t trigger_index = recorder.getTriggerIndex();
+    int16_t threshold = static_cast<int16_t>(recorder.getDisturbanceThreshold() * 1000.0f);
+    memcpy(&payload[4], &recorded, sizeof(recorded));
+    memcpy(&payload[6], &trigger_index, sizeof(trigger_index));
+    payload[8] = recorder.getTriggerMask();
+    memcpy(&payload[9], &threshold, sizeof(threshold));
+
+    sendIsoTp(payload, sizeof(payload));
+}
+
+void Can::sendRecorderChunk()
+{
+    uint8_t payload[FLIGHT_RECORDER_CHUNK_SIZE];
+    uint16_t len = _leg->recorder.readChunk(RECORDER_DUMP_CAN, payload);
+    if (len > 0)
+    {
+        sendIsoTp(payload, len);
+    }
+}
+#endif
+
 void Can::handleCommandPayload(const uint8_t* d, uint16_t len)
 {
     if (len == 0)
@@ -335,7 +601,7 @@ void Can::handleCommandPayload(const uint8_t* d, uint16_t len)
 
         case CMD_LINEAR_MOVE:
         {
-            if (len < 10)
+            if (len < 9)
             {
                 #if LOG_LEVEL >= CAN_DEBUG
                     Serial.println("CAN: Invalid linear move payload");
@@ -359,6 +625,7 @@ void Can::handleCommandPayload(const uint8_t* d, uint16_t len)
             command.linear_move.y = decodeScaledInt16(y_raw);
             command.linear_move.z = decodeScaledInt16(z_raw);
             command.linear_move.speed = decodeScaledInt16(speed_raw);
+            command.execute_at_us = decodeExecuteTime(d, len, 9);
 
             if (LOG_LEVEL >= CAN_DEBUG)
             {
@@ -385,12 +652,107 @@ void Can::handleCommandPayload(const uint8_t* d, uint16_t len)
             return;
         }
 
+        case CMD_ENCODER_DIAG:
+        {
+            sendEncoderDiagnostics();
+            return;
+        }
+
+        case CMD_TIME_SYNC:
+        {
+            sendTimeSyncStatus();
+            if (len > 1 && d[1] != 0)
+            {
+                time_sync.resetStats();
+            }
+            return;
+        }
+
+#if FLIGHT_RECORDER
+        case CMD_FLIGHT_RECORDER:
+        {
+            uint8_t op = len > 1 ? d[1] : FLIGHT_RECORDER_OP_STATUS;
+            if (op == FLIGHT_RECORDER_OP_TRIGGER)
+            {
+                _leg->recorder.trigger(RECORDER_REASON_MANUAL);
+            }
+            else if (op == FLIGHT_RECORDER_OP_ARM)
+            {
+                if (len < 5)
+                {
+                    #if LOG_LEVEL >= CAN_DEBUG
+                        Serial.println("CAN: Invalid flight recorder arm payload");
+                    #endif
+                    return;
+                }
+                int16_t threshold_raw = 0;
+                memcpy(&threshold_raw, &d[3], sizeof(int16_t));
+                _leg->recorder.arm(d[2], static_cast<float>(threshold_raw) / 1000.0f);
+            }
+            else if (op == FLIGHT_RECORDER_OP_DUMP && _leg->recorder.startDump(RECORDER_DUMP_CAN))
+            {
+                return;
+            }
+            sendRecorderStatus();
+            return;
+        }
+#endif
+
+#if LOOP_PROFILER
+        case CMD_LOOP_PROFILE:
+        {
+            sendLoopProfile();
+            if (len > 1 && d[1] != 0)
+            {
+                Profiler::reset();
+            }
+            return;
+        }
+#endif
+
         case CMD_QUADRATIC_MOVE:
         {
-            #if LOG_LEVEL >= CAN_DEBUG
-                Serial.println("CAN: Quadratic move command received");
-            #endif
-            //TODO
+            if (len < 16)
+            {
+                #if LOG_LEVEL >= CAN_DEBUG
+                    Serial.println("CAN: Invalid quadratic move payload");
+                #endif
+                return;
+            }
+
+            Command command{};
+            command.type = CommandType::QuadraticMove;
+            command.quadratic_move.through = (d[1] & 0x01) != 0;
+            for (uint8_t i = 0; i < 3; i++)
+            {
+                int16_t control_raw = 0;
+                int16_t end_raw = 0;
+                memcpy(&control_raw, &d[2 + 2 * i], sizeof(int16_t));
+                memcpy(&end_raw,     &d[8 + 2 * i], sizeof(int16_t));
+                command.quadratic_move.control[i] = decodeScaledInt16(control_raw);
+                command.quadratic_move.end[i] = decodeScaledInt16(end_raw);
+            }
+            uint16_t duration_ms = 0;
+            memcpy(&duration_ms, &d[14], sizeof(uint16_t));
+            command.quadratic_move.duration_ms = duration_ms;
+            command.execute_at_us = decodeExecuteTime(d, len, 16);
+
+            if (LOG_LEVEL >= CAN_DEBUG)
+            {
+                Serial.printf(
+                    "CAN: Quadratic move | leg %d | "
+                    "control %.3f %.3f %.3f end %.3f %.3f %.3f | %u ms\n",
+                    _leg_number,
+                    command.quadratic_move.control[0],
+                    command.quadratic_move.control[1],
+                    command.quadratic_move.control[2],
+                    command.quadratic_move.end[0],
+                    command.quadratic_move.end[1],
+                    command.quadratic_move.end[2],
+                    duration_ms
+                );
+            }
+            _leg->command_queue.enqueue(command);
             return;
         }
 
@@ -430,6 +792,7 @@ void Can::handleCommandPayload(const uint8_t* d, uint16_t len)
             command.type = CommandType::SingleAxisMove;
             command.single_axis.axis = axis;
             command.single_axis.position = pos;
+            command.execute_at_us = decodeExecuteTime(d, len, 4);
             _leg->command_queue.enqueue(command);
             return;
         }
@@ -472,6 +835,7 @@ void Can::handleCommandPayload(const uint8_t* d, uint16_t len)
             command.rapid_move.x = x;
             command.rapid_move.y = y;
             command.rapid_move.z = z;
+            command.execute_at_us = decodeExecuteTime(d, len, 7);
 
             _leg->command_queue.enqueue(command);
 
@@ -640,6 +1004,18 @@ void Can::canCallback(can2040 *cd, uint32_t notify, can2040_msg *msg)
             
 void Can::handleCanMessage(const CanMsg& msg)
 {
+    if (msg.id == TIME_SYNC_CAN_ID)
+    {
+        // read as soon as loop() gets to it, the lateness is filtered out in TimeSync
+        uint32_t rx_us = micros();
+        if (msg.data_length >= 5)
+        {
+            uint32_t bus_us;
+            memcpy(&bus_us, msg.data, sizeof(uint32_t));
+            time_sync.onSync(bus_us, msg.data[4], rx_us);
+        }
+        return;
+    }
     if (msg.id != _rx_node_id)
     {
         return;
@@ -798,8 +1174,6 @@ void Can::handleCanMessage(const CanMsg& msg)
 
 void Can::poll()
 {
-    uint32_t now = millis();
-
     if (_isotp_rx.active &&
         !isFresh(_isotp_rx.last_update))
     {
@@ -809,11 +1183,4 @@ void Can::poll()
 
         resetIsoTp();
     }
-
-    if ((now - _last_telemetry_tx) >= TELEMETRY_INTERVAL_MS)
-    {
-        _last_telemetry_tx = now;
-
-        sendLegTelemetry();
-    }
 }
@@ -1,6 +1,8 @@
 #include <Arduino.h>
 #include <RP2040PIO_CAN.h>
-#include <functional>
+#include "profiler.hpp"
+#include "flight_recorder.hpp"
+#include "time_sync.hpp"
 
 #ifndef HEX3_CAN
 #define HEX3_CAN
@@ -8,6 +10,7 @@
 class Leg;
 
 #define CAN_PIO    0
+#define CAN_TELEMETRY_INTERVAL_MS 100   // CMD_LEG_STATE broadcast period
 
 class Can
 {
@@ -22,8 +25,8 @@ class Can
         bool begin();
         void handleCanMessage(const CanMsg& msg);
         void poll();
-        std::function<void()> popPendingCommand();
         void canCallback(can2040 *cd, uint32_t notify, can2040_msg *msg);
+        TimeSync time_sync;
 
     private:
         uint8_t _rx_pin;
@@ -33,7 +36,6 @@ class Can
         uint32_t _tx_node_id;
         uint32_t _rx_node_id;
         Leg* _leg;
-        void queueCommand(std::function<void()> fn);
         void handleCommandPayload(
             const uint8_t* d,
             uint16_t len
@@ -43,6 +45,16 @@ class Can
             uint16_t len
         );
         void sendLegTelemetry();
+        void sendEncoderDiagnostics();
+        void sendTimeSyncStatus();
+        uint32_t decodeExecuteTime(const uint8_t* d, uint16_t len, uint16_t offset);
+#if LOOP_PROFILER
+        void sendLoopProfile();
+#endif
+#if FLIGHT_RECORDER
+        void sendRecorderStatus();
+        void sendRecorderChunk();
+#endif
         bool isFresh(uint32_t last);
 };
 
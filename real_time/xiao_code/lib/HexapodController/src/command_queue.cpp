@@ -8,13 +8,20 @@ bool CommandQueue::enqueue(const Command& cmd)
     if (count >= COMMAND_QUEUE_SIZE)
     {
         // queue full
+        stats.dropped++;
         Serial.println("Command queue FULL - dropping command");
         return false;
     }
 
     buffer[tail] = cmd;
+    buffer[tail].received_us = micros();
     tail = (tail + 1) % COMMAND_QUEUE_SIZE;
     count++;
+    stats.enqueued++;
+    if (count > stats.max_depth)
+    {
+        stats.max_depth = count;
+    }
 
     return true;
 }
@@ -33,6 +40,17 @@ bool CommandQueue::dequeue(Command& cmd)
     return true;
 }
 
+bool CommandQueue::peek(uint8_t index, Command& cmd) const
+{
+    if (index >= count)
+    {
+        return false;
+    }
+
+    cmd = buffer[(head + index) % COMMAND_QUEUE_SIZE];
+    return true;
+}
+
 bool CommandQueue::isEmpty() const
 {
     return count == 0;
@@ -42,3 +60,50 @@ uint8_t CommandQueue::size() const
 {
     return count;
 }
+
+bool CommandQueue::isDue(uint32_t now_us) const
+{
+    if (count == 0 || buffer[head].execute_at_us == 0)
+    {
+        return false;
+    }
+    // signed difference so the micros() wrap is harmless
+    return static_cast<int32_t>(now_us - buffer[head].execute_at_us) >= 0;
+}
+
+void CommandQueue::recordTimedStart(uint32_t late_us)
+{
+    stats.timed_starts++;
+    if (late_us > COMMAND_LATE_THRESHOLD_US)
+    {
+        stats.late_starts++;
+    }
+    if (late_us > stats.late_max_us)
+    {
+        stats.late_max_us = late_us;
+    }
+}
+
+void CommandQueue::recordHeldStart()
+{
+    stats.held_starts++;
+}
+
+CommandQueueStats CommandQueue::getStats() const
+{
+    return stats;
+}
+
+void CommandQueue::resetStats()
+{
+    stats = CommandQueueStats();
+    stats.max_depth = count;
+}
+
+void CommandQueue::printStats()
+{
+    Serial.printf("Command queue: %u queued, max %lu of %u, %lu enqueued, %lu dropped\n",
+        count, stats.max_depth, COMMAND_QUEUE_SIZE, stats.enqueued, stats.dropped);
+    Serial.printf("Timed starts: %lu, %lu later than %u us, worst %lu us late; %lu held behind a move\n",
+        stats.timed_starts, stats.late_starts, COMMAND_LATE_THRESHOLD_US, stats.late_max_us, stats.held_starts);
+}
@@ -5,7 +5,10 @@
 #ifndef FIFO_COMMAND
 #define FIFO_COMMAND
 
-#define COMMAND_QUEUE_SIZE 1
+#define COMMAND_QUEUE_SIZE 32            // lets the host stream timed commands ahead of time
+#define COMMAND_QUEUE_POLL_INTERVAL_US 1000
+#define COMMAND_LATE_THRESHOLD_US 2000   // starts later than this after execute_at_us count as late
+#define COMMAND_MAX_LEAD_US 1000000      // execute times further than this from now are treated as absent
 
 enum class CommandType : uint8_t
 {
@@ -19,6 +22,8 @@ enum class CommandType : uint8_t
 struct Command
 {
     CommandType type;
+    uint32_t execute_at_us;     // micros() not to start before, 0 = as soon as the previous move has finished
+    uint32_t received_us;       // micros() when it was queued, set by enqueue()
     union //TODO add other commands as needed
     {
         struct
@@ -41,23 +46,53 @@ struct Command
             float z;
             float speed;
         } linear_move;
+
+        struct
+        {
+            float control[3];   // Bézier control point, or a point passed at half time with through
+            float end[3];
+            uint32_t duration_ms;
+            bool through;
+        } quadratic_move;
     };
 };
 
+struct CommandQueueStats
+{
+    uint32_t enqueued = 0;
+    uint32_t dropped = 0;       // arrived while the queue was full
+    uint32_t timed_starts = 0;  // timed commands that found the leg idle and started on schedule
+    uint32_t late_starts = 0;   // of those, more than COMMAND_LATE_THRESHOLD_US late
+    uint32_t late_max_us = 0;
+    uint32_t held_starts = 0;   // timed commands that waited behind a running move, lateness not counted
+    uint32_t max_depth = 0;
+};
+
 //using a ring buffer for command queue, with head/tail indices and count
+//commands start in arrival order; peek() lets the trajectory layer look ahead
 class CommandQueue
 {
     public:
         bool enqueue(const Command& cmd);
         bool dequeue(Command& cmd);
+        // index 0 is the next command to start
+        bool peek(uint8_t index, Command& cmd) const;
         bool isEmpty() const;
         uint8_t size() const;
+        // true if the next command is timed and its time has come
+        bool isDue(uint32_t now_us) const;
+        void recordTimedStart(uint32_t late_us);
+        void recordHeldStart();
+        CommandQueueStats getStats() const;
+        void resetStats();
+        void printStats();
 
     private:
         Command buffer[COMMAND_QUEUE_SIZE];
         volatile uint8_t head = 0;
         volatile uint8_t tail = 0;
         volatile uint8_t count = 0;
+        CommandQueueStats stats;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,50 @@
+/**
+ * @file cycle_counter.hpp
+ * @brief Cortex-M33 DWT cycle counter for timing code sections
+ *
+ * micros() is too coarse to compare a few hundred instructions, so benchmarks
+ * read the core clock cycle counter instead. The counter is per core and wraps
+ * every 2^32 cycles (~28 s at 150 MHz); differences of two reads are valid as
+ * long as the section is shorter than that.
+ */
+
+#include <stdint.h>
+
+#ifndef HEX3_CYCLE_COUNTER
+#define HEX3_CYCLE_COUNTER
+
+    #define CYCLE_COUNTER_DEMCR       (*(volatile uint32_t*)0xE000EDFC)   ///< Debug Exception and Monitor Control
+    #define CYCLE_COUNTER_DWT_CTRL    (*(volatile uint32_t*)0xE0001000)
+    #define CYCLE_COUNTER_DWT_CYCCNT  (*(volatile uint32_t*)0xE0001004)
+    #define CYCLE_COUNTER_TRCENA      (1UL << 24)
+    #define CYCLE_COUNTER_CYCCNTENA   (1UL << 0)
+
+    /// Enable the counter on the calling core, safe to call more than once
+    static inline void cycleCounterBegin() {
+        CYCLE_COUNTER_DEMCR |= CYCLE_COUNTER_TRCENA;
+        CYCLE_COUNTER_DWT_CTRL |= CYCLE_COUNTER_CYCCNTENA;
+    }
+
+    static inline uint32_t cycleCount() {
+        return CYCLE_COUNTER_DWT_CYCCNT;
+    }
+
+    /// Running min/mean/max of a timed section, in cycles
+    struct CycleStats {
+        uint32_t count = 0;
+        uint32_t min = UINT32_MAX;
+        uint32_t max = 0;
+        uint64_t sum = 0;
+
+        void add(uint32_t cycles) {
+            count++;
+            sum += cycles;
+            if (cycles < min) min = cycles;
+            if (cycles > max) max = cycles;
+        }
+        uint32_t mean() const {
+            return count ? static_cast<uint32_t>(sum / count) : 0;
+        }
+    };
+
+#endif
@@ -0,0 +1,144 @@
+#include "flight_recorder.hpp"
+#include <math.h>
+#include <string.h>
+
+#if FLIGHT_RECORDER
+
+/**
+ * @brief Store one sample and advance the trigger state
+ *
+ * Pending arm and trigger requests are applied here, so the buffer indices
+ * only ever change in the control step.
+ */
+void FlightRecorder::record(const FlightRecorderSample& sample) {
+    if (_arm_request.load(std::memory_order_acquire)) {
+        _write_index = 0;
+        _recorded = 0;
+        _trigger_request.store(RECORDER_REASON_NONE, std::memory_order_relaxed);
+        _reason.store(RECORDER_REASON_NONE, std::memory_order_relaxed);
+        _state.store(RECORDER_RECORDING, std::memory_order_relaxed);
+        _arm_request.store(false, std::memory_order_release);
+    }
+    uint8_t state = _state.load(std::memory_order_relaxed);
+    if (state == RECORDER_FROZEN) {
+        return;
+    }
+
+    uint16_t slot = _write_index;
+    memcpy(&_samples[slot], &sample, sizeof(FlightRecorderSample));
+    _write_index = (slot + 1) % FLIGHT_RECORDER_SAMPLES;
+    if (_recorded < FLIGHT_RECORDER_SAMPLES) {
+        _recorded++;
+    }
+
+    if (state == RECORDER_RECORDING) {
+        uint8_t reason = _trigger_request.exchange(RECORDER_REASON_NONE, std::memory_order_acquire);
+        float threshold = _disturbance_threshold.load(std::memory_order_relaxed);
+        if (reason == RECORDER_REASON_NONE && (_trigger_mask.load(std::memory_order_relaxed) & FLIGHT_RECORDER_TRIGGER_DISTURBANCE) && threshold > 0.0f) {
+            for (uint8_t i = 0; i < 3; i++) {
+                if (fabsf(sample.disturbance[i]) > threshold) {
+                    reason = RECORDER_REASON_DISTURBANCE;
+                }
+            }
+        }
+        if (reason != RECORDER_REASON_NONE) {
+            _trigger_index = slot;
+            _post_remaining = FLIGHT_RECORDER_POST_TRIGGER;
+            _reason.store(reason, std::memory_order_relaxed);
+            _state.store(RECORDER_TRIGGERED, std::memory_order_release);
+        }
+    }
+    else if (--_post_remaining == 0) {
+        _state.store(RECORDER_FROZEN, std::memory_order_release);
+    }
+}
+
+/// The first trigger while recording wins, later ones are ignored until re-armed
+void FlightRecorder::trigger(FlightRecorderReason reason) {
+    if (_state.load(std::memory_order_acquire) != RECORDER_RECORDING) {
+        return;
+    }
+    uint8_t none = RECORDER_REASON_NONE;
+    _trigger_request.compare_exchange_strong(none, reason, std::memory_order_release);
+}
+
+void FlightRecorder::arm(uint8_t trigger_mask, float disturbance_threshold) {
+    _trigger_mask.store(trigger_mask, std::memory_order_relaxed);
+    _disturbance_threshold.store(disturbance_threshold, std::memory_order_relaxed);
+    _dump_target = RECORDER_DUMP_NONE;
+    _arm_request.store(true, std::memory_order_release);
+}
+
+void FlightRecorder::notifyCommand() {
+    if (_trigger_mask.load(std::memory_order_relaxed) & FLIGHT_RECORDER_TRIGGER_COMMAND) {
+        trigger(RECORDER_REASON_COMMAND);
+    }
+}
+
+FlightRecorderState FlightRecorder::getState() {
+    return static_cast<FlightRecorderState>(_state.load(std::memory_order_acquire));
+}
+
+FlightRecorderReason FlightRecorder::getReason() {
+    return static_cast<FlightRecorderReason>(_reason.load(std::memory_order_relaxed));
+}
+
+uint8_t FlightRecorder::getTriggerMask() {
+    return _trigger_mask.load(std::memory_order_relaxed);
+}
+
+float FlightRecorder::getDisturbanceThreshold() {
+    return _disturbance_threshold.load(std::memory_order_relaxed);
+}
+
+/// Samples held, only settled once frozen
+uint16_t FlightRecorder::getRecorded() {
+    return _recorded;
+}
+
+/// Position of the trigger sample counted from the oldest, only settled once frozen
+uint16_t FlightRecorder::getTriggerIndex() {
+    uint16_t oldest = (_write_index + FLIGHT_RECORDER_SAMPLES - _recorded) % FLIGHT_RECORDER_SAMPLES;
+    return (_trigger_index + FLIGHT_RECORDER_SAMPLES - oldest) % FLIGHT_RECORDER_SAMPLES;
+}
+
+bool FlightRecorder::startDump(FlightRecorderTarget target) {
+    if (getState() != RECORDER_FROZEN || _arm_request.load(std::memory_order_acquire)) {
+        return false;
+    }
+    _dump_target = target;
+    _dump_next = 0;
+    return true;
+}
+
+uint16_t FlightRecorder::readChunk(FlightRecorderTarget target, uint8_t* payload) {
+    if (_dump_target != target || target == RECORDER_DUMP_NONE) {
+        return 0;
+    }
+    if (_dump_next >= _recorded) {
+        _dump_target = RECORDER_DUMP_NONE;
+        return 0;
+    }
+    uint16_t count = _recorded - _dump_next;
+    if (count > FLIGHT_RECORDER_CHUNK_SAMPLES) {
+        count = FLIGHT_RECORDER_CHUNK_SAMPLES;
+    }
+    uint16_t oldest = (_write_index + FLIGHT_RECORDER_SAMPLES - _recorded) % FLIGHT_RECORDER_SAMPLES;
+    uint16_t trigger_index = getTriggerIndex();
+
+    payload[0] = FLIGHT_RECORDER_CAN_COMMAND;
+    payload[1] = FLIGHT_RECORDER_OP_DATA;
+    payload[2] = getReason();
+    payload[3] = static_cast<uint8_t>(count);
+    memcpy(&payload[4], &_recorded, sizeof(uint16_t));
+    memcpy(&payload[6], &_dump_next, sizeof(uint16_t));
+    memcpy(&payload[8], &trigger_index, sizeof(uint16_t));
+    for (uint16_t i = 0; i < count; i++) {
+        uint16_t slot = (oldest + _dump_next + i) % FLIGHT_RECORDER_SAMPLES;
+        memcpy(&payload[FLIGHT_RECORDER_CHUNK_HEADER + i * sizeof(FlightRecorderSample)], &_samples[slot], sizeof(FlightRecorderSample));
+    }
+    _dump_next += count;
+    return FLIGHT_RECORDER_CHUNK_HEADER + count * sizeof(FlightRecorderSample);
+}
+
+#endif
@@ -0,0 +1,126 @@
+/**
+ * @file flight_recorder.hpp
+ * @brief RAM recorder of every control cycle, frozen by a trigger and dumped afterwards
+ *
+ * record() runs at the end of each control step and overwrites the oldest of
+ * FLIGHT_RECORDER_SAMPLES samples. A trigger - manual (CAN or serial), a MOB
+ * disturbance above a threshold, or a queued command starting - marks the
+ * current sample; FLIGHT_RECORDER_POST_TRIGGER more samples are taken and the
+ * buffer then freezes, so it holds the lead-up to the event and what followed.
+ *
+ * A frozen buffer is read out in chunks of FLIGHT_RECORDER_CHUNK_SAMPLES, over
+ * CAN (ISO-TP, CMD_FLIGHT_RECORDER in can.cpp) or USB (framed as in
+ * telemetry_frame.hpp). Both carry the same chunk payload:
+ *   Byte 0      FLIGHT_RECORDER_CAN_COMMAND (0x23)
+ *   Byte 1      FLIGHT_RECORDER_OP_DATA
+ *   Byte 2      trigger reason
+ *   Byte 3      samples in this chunk
+ *   Byte 4..5   uint16 samples in the recording
+ *   Byte 6..7   uint16 index of the first sample in this chunk, 0 is the oldest
+ *   Byte 8..9   uint16 index of the trigger sample
+ *   Byte 10..   FlightRecorderSample[], little endian
+ * telemetry_tools' recorder_to_csv rebuilds the time series from either.
+ *
+ * The control step is the only writer of the buffer. Triggers and re-arming
+ * are requests it picks up on its next sample, and chunks are only read once
+ * it has frozen, so no side takes a lock.
+ */
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <atomic>
+#include "user_config.hpp"
+
+#ifndef HEX3_FLIGHT_RECORDER
+#define HEX3_FLIGHT_RECORDER
+
+    #ifndef FLIGHT_RECORDER
+        #define FLIGHT_RECORDER false
+    #endif
+    #ifndef FLIGHT_RECORDER_SAMPLES
+        #define FLIGHT_RECORDER_SAMPLES 1024    ///< ~1 s at the 1 kHz control rate, 68 kB
+    #endif
+    #define FLIGHT_RECORDER_POST_TRIGGER (FLIGHT_RECORDER_SAMPLES / 4)
+    #define FLIGHT_RECORDER_CHUNK_SAMPLES 2     ///< per dump message, 146 byte payload
+    #define FLIGHT_RECORDER_CHUNK_HEADER 10
+    #define FLIGHT_RECORDER_CAN_CHUNK_INTERVAL_MS 20   ///< ~21 CAN frames per chunk, keeps the dump near a quarter of the bus
+
+    #define FLIGHT_RECORDER_CAN_COMMAND 0x23    ///< CMD_FLIGHT_RECORDER, first byte of every request and reply
+    #define FLIGHT_RECORDER_OP_STATUS  0x00
+    #define FLIGHT_RECORDER_OP_TRIGGER 0x01
+    #define FLIGHT_RECORDER_OP_ARM     0x02
+    #define FLIGHT_RECORDER_OP_DUMP    0x03
+    #define FLIGHT_RECORDER_OP_DATA    0x04
+
+    #define FLIGHT_RECORDER_TRIGGER_DISTURBANCE (1 << 0)   ///< arm mask bits
+    #define FLIGHT_RECORDER_TRIGGER_COMMAND     (1 << 1)
+
+    enum FlightRecorderReason : uint8_t {
+        RECORDER_REASON_NONE,
+        RECORDER_REASON_MANUAL,
+        RECORDER_REASON_DISTURBANCE,
+        RECORDER_REASON_COMMAND
+    };
+
+    enum FlightRecorderState : uint8_t {
+        RECORDER_RECORDING,
+        RECORDER_TRIGGERED,                 ///< taking the post-trigger samples
+        RECORDER_FROZEN
+    };
+
+    enum FlightRecorderTarget : uint8_t {
+        RECORDER_DUMP_NONE,
+        RECORDER_DUMP_USB,
+        RECORDER_DUMP_CAN
+    };
+
+    struct FlightRecorderSample {
+        uint32_t timestamp_us;
+        float pos[3];                       ///< rad
+        float vel[3];                       ///< rad/s
+        float target[3];                    ///< rad
+        float duty[3];                      ///< %
+        float disturbance[3];               ///< MOB disturbance torque estimate
+        float toe;
+    };
+    static_assert(sizeof(FlightRecorderSample) == 68, "FlightRecorderSample layout is shared with the host tool");
+
+    #define FLIGHT_RECORDER_CHUNK_SIZE (FLIGHT_RECORDER_CHUNK_HEADER + FLIGHT_RECORDER_CHUNK_SAMPLES * sizeof(FlightRecorderSample))
+
+    class FlightRecorder {
+        public:
+            /// Store one control cycle, control step only
+            void record(const FlightRecorderSample& sample);
+            void trigger(FlightRecorderReason reason);
+            /// Discard the recording and start over with the given trigger mask and disturbance threshold
+            void arm(uint8_t trigger_mask, float disturbance_threshold);
+            /// A queued command started executing
+            void notifyCommand();
+            FlightRecorderState getState();
+            FlightRecorderReason getReason();
+            uint8_t getTriggerMask();
+            float getDisturbanceThreshold();
+            uint16_t getRecorded();
+            uint16_t getTriggerIndex();
+            /// Start reading a frozen recording out to target, false if not frozen
+            bool startDump(FlightRecorderTarget target);
+            /// Next chunk payload for target into payload (FLIGHT_RECORDER_CHUNK_SIZE bytes), 0 when done or not dumping there
+            uint16_t readChunk(FlightRecorderTarget target, uint8_t* payload);
+
+        private:
+            FlightRecorderSample _samples[FLIGHT_RECORDER_SAMPLES];
+            uint16_t _write_index = 0;          ///< next slot, control step only
+            uint16_t _recorded = 0;
+            uint16_t _post_remaining = 0;
+            uint16_t _trigger_index = 0;        ///< slot of the trigger sample
+            std::atomic<uint8_t> _state{RECORDER_RECORDING};
+            std::atomic<uint8_t> _reason{RECORDER_REASON_NONE};
+            std::atomic<uint8_t> _trigger_request{RECORDER_REASON_NONE};
+            std::atomic<bool> _arm_request{false};
+            std::atomic<uint8_t> _trigger_mask{0};
+            std::atomic<float> _disturbance_threshold{0.0f};
+            FlightRecorderTarget _dump_target = RECORDER_DUMP_NONE;
+            uint16_t _dump_next = 0;
+    };
+
+#endif
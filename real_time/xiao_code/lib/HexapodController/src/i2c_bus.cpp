@@ -0,0 +1,313 @@
+/**
+ * @file i2c_bus.cpp
+ * @brief Implementation of the shared I2C bus scheduler and its register-level engine
+ */
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <Wire.h>
+#include <hardware/i2c.h>
+#include "i2c_bus.hpp"
+
+/// true if micros() timestamp a is at or after b, wrap-safe
+static bool timeReached(uint32_t a, uint32_t b) {
+    return static_cast<int32_t>(a - b) >= 0;
+}
+
+I2CBus::I2CBus() {}
+
+/**
+ * @brief Start Wire and take over its controller
+ *
+ * Blocking library calls (sensor setup) may still use Wire until the sensing
+ * task starts calling poll().
+ */
+void I2CBus::begin() {
+    Wire.begin();
+    Wire.setClock(400000); // Set I2C clock to 400kHz
+    Wire.setTimeout(20, true);
+    _hw = i2c_get_hw(MUX_I2C_PORT);
+}
+
+bool I2CBus::probe(uint8_t address) {
+    Wire.beginTransmission(address);
+    return Wire.endTransmission() == 0;
+}
+
+/**
+ * @brief Queue a request
+ *
+ * The request is referenced, not copied - it must stay alive and untouched until
+ * its status is DONE or FAILED.
+ *
+ * @return false if the request is already queued/active, malformed, or the queue is full
+ */
+bool I2CBus::submit(I2CRequest& request) {
+    if (isPending(request) || _hw == nullptr) {
+        return false;
+    }
+    if (request.tx_len > I2C_MAX_TRANSFER || request.rx_len > I2C_MAX_TRANSFER || (request.tx_len == 0 && request.rx_len == 0)) {
+        return false;
+    }
+    if (_queue_len >= I2C_BUS_MAX_REQUESTS) {
+        return false;
+    }
+    request.status = I2CStatus::PENDING;
+    _queue[_queue_len++] = &request;
+    return true;
+}
+
+/**
+ * @brief Move a queued request to a new release time and deadline
+ *
+ * @return false if the request is not waiting in the queue (already on the wire or finished)
+ */
+bool I2CBus::reschedule(I2CRequest& request, uint32_t release_us, uint32_t deadline_us) {
+    if (request.status != I2CStatus::PENDING) {
+        return false;
+    }
+    request.release_us = release_us;
+    request.deadline_us = deadline_us;
+    return true;
+}
+
+bool I2CBus::isPending(const I2CRequest& request) {
+    return request.status == I2CStatus::PENDING || request.status == I2CStatus::ACTIVE;
+}
+
+bool I2CBus::isIdle() {
+    return _state == I2CBusState::IDLE;
+}
+
+uint8_t I2CBus::selectedChannel() {
+    return _last_channel;
+}
+
+/**
+ * @brief Advance the bus, never blocks
+ *
+ * Each call does at most one state transition: queue bytes into the controller
+ * FIFO, or check whether the controller has finished with them. A transfer with
+ * a channel switch is SELECTING -> SETTLING -> TRANSFERRING -> IDLE; a transfer
+ * on the selected channel (or a device on the main bus) goes straight to TRANSFERRING.
+ */
+void I2CBus::poll() {
+    if (_hw == nullptr) {
+        return;
+    }
+
+    if (_state != I2CBusState::IDLE && _state != I2CBusState::SETTLING &&
+        micros() - _transaction_start_us > I2C_TRANSACTION_TIMEOUT_US) {
+        // controller is wedged - disabling it flushes the FIFOs and drops the transfer
+        _hw->enable = 0;
+        _hw->enable = I2C_IC_ENABLE_ENABLE_BITS;
+        _last_channel = 255;
+        _complete(false);
+        return;
+    }
+
+    switch (_state) {
+        case I2CBusState::IDLE:
+        {
+            I2CRequest* next = _selectNext(micros());
+            if (next != nullptr) {
+                _start(next);
+            }
+            break;
+        }
+
+        case I2CBusState::SELECTING:
+        {
+            int8_t result = _transferResult();
+            if (result < 0) {
+                break;
+            }
+            if (result > 0) {
+                _last_channel = 255;
+                _complete(false);
+                break;
+            }
+            _last_channel = _active->channel;
+            _state = I2CBusState::SETTLING;
+            _state_start_us = micros();
+            break;
+        }
+
+        case I2CBusState::SETTLING:
+            if (micros() - _state_start_us >= MUX_SETTLE_US) {
+                _startTransfer();
+            }
+            break;
+
+        case I2CBusState::TRANSFERRING:
+        {
+            int8_t result = _transferResult();
+            if (result < 0) {
+                break;
+            }
+            if (result > 0 || _hw->rxflr < _active->rx_len) {
+                _complete(false);
+                break;
+            }
+            for (uint8_t i = 0; i < _active->rx_len; i++) {
+                _active->rx[i] = _hw->data_cmd & 0xFF;
+            }
+            _complete(true);
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Pick the next request to run according to the priority/deadline rules
+ *
+ * @return request to start, or nullptr if nothing is eligible yet
+ */
+I2CRequest* I2CBus::_selectNext(uint32_t now) {
+    I2CRequest* best_critical = nullptr;
+    I2CRequest* same_channel_critical = nullptr;
+    I2CRequest* best_background = nullptr;
+    bool critical_waiting = false;
+    uint32_t next_critical_release = 0;
+
+    for (uint8_t i = 0; i < _queue_len; i++) {
+        I2CRequest* request = _queue[i];
+        if (request->priority == I2CPriority::CRITICAL) {
+            if (!timeReached(now, request->release_us)) {
+                if (!critical_waiting || timeReached(next_critical_release, request->release_us)) {
+                    next_critical_release = request->release_us;
+                }
+                critical_waiting = true;
+                continue;
+            }
+            if (best_critical == nullptr || timeReached(best_critical->deadline_us, request->deadline_us + 1)) {
+                best_critical = request;
+            }
+            if (request->channel == _last_channel || request->channel == I2C_NO_CHANNEL) {
+                if (same_channel_critical == nullptr || timeReached(same_channel_critical->deadline_us, request->deadline_us + 1)) {
+                    same_channel_critical = request;
+                }
+            }
+        }
+        else if (timeReached(now, request->release_us)) {
+            if (best_background == nullptr || timeReached(best_background->deadline_us, request->deadline_us + 1)) {
+                best_background = request;
+            }
+        }
+    }
+
+    if (best_critical != nullptr) {
+        // skip a mux switch if it costs the earliest deadline less than the switch itself would
+        if (same_channel_critical != nullptr &&
+            timeReached(best_critical->deadline_us + I2C_CHANNEL_SWITCH_COST_US, same_channel_critical->deadline_us)) {
+            return same_channel_critical;
+        }
+        return best_critical;
+    }
+
+    if (best_background != nullptr) {
+        if (critical_waiting && !timeReached(next_critical_release, now + _estimateDuration(*best_background))) {
+            return nullptr; // would still be on the wire when an encoder read is due
+        }
+        return best_background;
+    }
+    return nullptr;
+}
+
+uint32_t I2CBus::_estimateDuration(const I2CRequest& request) {
+    uint32_t bytes = 1 + request.tx_len + request.rx_len;
+    if (request.tx_len > 0 && request.rx_len > 0) {
+        bytes++; // address byte again after the repeated start
+    }
+    uint32_t duration = bytes * I2C_BYTE_TIME_US + I2C_TRANSACTION_OVERHEAD_US;
+    if (request.channel != I2C_NO_CHANNEL && request.channel != _last_channel) {
+        duration += I2C_CHANNEL_SWITCH_COST_US;
+    }
+    return duration;
+}
+
+void I2CBus::_start(I2CRequest* request) {
+    for (uint8_t i = 0; i < _queue_len; i++) {
+        if (_queue[i] == request) {
+            _queue[i] = _queue[--_queue_len];
+            break;
+        }
+    }
+    _active = request;
+    _active->status = I2CStatus::ACTIVE;
+    _transaction_start_us = micros();
+    _active->started_us = _transaction_start_us;
+    if (_active->channel == I2C_NO_CHANNEL || _active->channel == _last_channel) {
+        _startTransfer();
+    }
+    else {
+        _startSelect(_active->channel);
+    }
+}
+
+void I2CBus::_startSelect(uint8_t channel) {
+    _setTarget(MUX_ADDR);
+    _hw->data_cmd = (1 << channel) | I2C_IC_DATA_CMD_STOP_BITS;
+    _state = I2CBusState::SELECTING;
+}
+
+void I2CBus::_startTransfer() {
+    _setTarget(_active->address);
+    for (uint8_t i = 0; i < _active->tx_len; i++) {
+        uint32_t cmd = _active->tx[i];
+        if (_active->rx_len == 0 && i == _active->tx_len - 1) {
+            cmd |= I2C_IC_DATA_CMD_STOP_BITS;
+        }
+        _hw->data_cmd = cmd;
+    }
+    for (uint8_t i = 0; i < _active->rx_len; i++) {
+        uint32_t cmd = I2C_IC_DATA_CMD_CMD_BITS;
+        if (i == 0 && _active->tx_len > 0) {
+            cmd |= I2C_IC_DATA_CMD_RESTART_BITS;
+        }
+        if (i == _active->rx_len - 1) {
+            cmd |= I2C_IC_DATA_CMD_STOP_BITS;
+        }
+        _hw->data_cmd = cmd;
+    }
+    _state = I2CBusState::TRANSFERRING;
+}
+
+/**
+ * @brief Point the controller at a new target address and clear stale status
+ *
+ * The target address can only be changed while the controller is disabled. The
+ * previous transfer has always seen its STOP by the time we get here.
+ */
+void I2CBus::_setTarget(uint8_t address) {
+    _hw->enable = 0;
+    _hw->tar = address;
+    _hw->enable = I2C_IC_ENABLE_ENABLE_BITS;
+    (void)_hw->clr_tx_abrt;
+    (void)_hw->clr_stop_det;
+}
+
+/**
+ * @brief Check whether the queued transfer has finished
+ *
+ * @return -1 still in progress, 0 completed, 1 aborted (NACK, arbitration loss)
+ */
+int8_t I2CBus::_transferResult() {
+    uint32_t status = _hw->raw_intr_stat;
+    if (!(status & I2C_IC_RAW_INTR_STAT_STOP_DET_BITS)) {
+        return -1;
+    }
+    (void)_hw->clr_stop_det;
+    if (status & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS) {
+        (void)_hw->clr_tx_abrt;
+        return 1;
+    }
+    return 0;
+}
+
+void I2CBus::_complete(bool ok) {
+    _active->completed_us = micros();
+    _active->status = ok ? I2CStatus::DONE : I2CStatus::FAILED;
+    _active = nullptr;
+    _state = I2CBusState::IDLE;
+}
@@ -0,0 +1,112 @@
+/**
+ * @file i2c_bus.hpp
+ * @brief Scheduler for the shared I2C bus (multiplexer, encoders, toe sensor)
+ *
+ * One object owns `Wire` and the I2C controller behind it. Clients describe a
+ * register transfer in an I2CRequest they own and submit it; poll() runs one
+ * transfer at a time without blocking, switching the multiplexer channel only
+ * when needed.
+ *
+ * Scheduling rules:
+ * - CRITICAL requests (encoders) run earliest-deadline-first once released.
+ *   A released request on the channel that is already selected is preferred if
+ *   its deadline is within one channel switch of the earliest one.
+ * - BACKGROUND requests (toe, probes) only start when no CRITICAL request is
+ *   released and their estimated duration ends before the next CRITICAL release,
+ *   so they can never push an encoder read back.
+ */
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <Wire.h>
+#include <hardware/i2c.h>
+
+#ifndef HEX3_I2C_BUS
+#define HEX3_I2C_BUS
+
+    #define MUX_ADDR 0x70
+    #define I2C_NO_CHANNEL 255               ///< device sits on the main bus, reachable on any mux channel
+    #define I2C_BUS_MAX_REQUESTS 12
+    #define I2C_MAX_TRANSFER 4               ///< max bytes written or read by one request
+
+    #define MUX_SETTLE_US 500                 // settle time after a channel switch before the device is addressed
+    #define I2C_TRANSACTION_TIMEOUT_US 2000   // abandon a transfer that has not completed after this long
+    #define I2C_BYTE_TIME_US 25               // one byte + ACK at 400 kHz, rounded up
+    #define I2C_TRANSACTION_OVERHEAD_US 30    // start/stop and register setup
+    #define I2C_CHANNEL_SWITCH_COST_US (MUX_SETTLE_US + 2 * I2C_BYTE_TIME_US + I2C_TRANSACTION_OVERHEAD_US)
+
+    // I2C controller that sits behind `Wire`. The engine drives it at register
+    // level, so this must match the controller Wire was started on (XIAO RP2350 D4/D5 -> I2C1).
+    #ifndef MUX_I2C_PORT
+        #define MUX_I2C_PORT i2c1
+    #endif
+
+    enum class I2CPriority : uint8_t {
+        CRITICAL,       ///< encoders - run earliest-deadline-first as soon as released
+        BACKGROUND      ///< toe, probes - only run in the slack between critical requests
+    };
+
+    enum class I2CStatus : uint8_t {
+        IDLE,       ///< never submitted
+        PENDING,    ///< queued, waiting for its turn
+        ACTIVE,     ///< on the wire
+        DONE,       ///< completed, rx[] valid
+        FAILED      ///< NACK, arbitration loss or timeout
+    };
+
+    /// One register transfer: write tx[], then (with a repeated start) read rx_len bytes into rx[]
+    struct I2CRequest {
+        uint8_t address = 0;
+        uint8_t channel = I2C_NO_CHANNEL;
+        I2CPriority priority = I2CPriority::BACKGROUND;
+        uint8_t tx[I2C_MAX_TRANSFER] = {0};
+        uint8_t tx_len = 0;
+        uint8_t rx[I2C_MAX_TRANSFER] = {0};
+        uint8_t rx_len = 0;
+        uint32_t release_us = 0;      ///< not started before this micros() value
+        uint32_t deadline_us = 0;     ///< ordering key among requests of the same priority
+        uint32_t started_us = 0;      ///< micros() when the transfer went on the wire
+        uint32_t completed_us = 0;    ///< micros() when the transfer finished
+        volatile I2CStatus status = I2CStatus::IDLE;
+    };
+
+    enum class I2CBusState : uint8_t {
+        IDLE,           ///< no transfer in flight
+        SELECTING,      ///< channel select byte queued to the mux
+        SETTLING,       ///< waiting MUX_SETTLE_US after a channel switch
+        TRANSFERRING    ///< request bytes queued to the device
+    };
+
+    class I2CBus {
+        public:
+            I2CBus();
+            void begin();
+            bool probe(uint8_t address);    ///< blocking, setup only
+            bool submit(I2CRequest& request);
+            bool reschedule(I2CRequest& request, uint32_t release_us, uint32_t deadline_us);
+            bool isPending(const I2CRequest& request);
+            void poll();
+            bool isIdle();
+            uint8_t selectedChannel();
+
+        private:
+            i2c_hw_t* _hw = nullptr;
+            I2CBusState _state = I2CBusState::IDLE;
+            I2CRequest* _queue[I2C_BUS_MAX_REQUESTS];
+            uint8_t _queue_len = 0;
+            I2CRequest* _active = nullptr;
+            uint8_t _last_channel = 255;
+            uint32_t _state_start_us = 0;
+            uint32_t _transaction_start_us = 0;
+
+            I2CRequest* _selectNext(uint32_t now);
+            uint32_t _estimateDuration(const I2CRequest& request);
+            void _start(I2CRequest* request);
+            void _startSelect(uint8_t channel);
+            void _startTransfer();
+            void _setTarget(uint8_t address);
+            int8_t _transferResult();
+            void _complete(bool ok);
+    };
+
+#endif
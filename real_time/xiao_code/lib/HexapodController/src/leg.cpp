@@ -18,42 +18,218 @@
 #include <math.h>
 #include "three_by_matrices.hpp"
 #include <Arduino.h>
+#include <new>
 #include "log_levels.hpp"
 #include "mux.hpp"
 #include "command_queue.hpp"
+#include "kinematics_math.hpp"
+#include "profiler.hpp"
+#include <hardware/sync.h>
+#if LEG_CONTROL_ISR
+    #include <hardware/timer.h>
+    #include <hardware/irq.h>
+#endif
 
 // Configuration tables loaded from config.hpp
-double zero_points[NUM_LEGS][NUM_AXES_PER_LEG] = ZERO_POINTS;
-double min_pos[NUM_LEGS][NUM_AXES_PER_LEG] = MIN_POS;
-double max_pos[NUM_LEGS][NUM_AXES_PER_LEG] = MAX_POS;
-double scale_fact[NUM_LEGS][NUM_AXES_PER_LEG] = SCALE_FACT;
+float zero_points[NUM_LEGS][NUM_AXES_PER_LEG] = ZERO_POINTS;
+float min_pos[NUM_LEGS][NUM_AXES_PER_LEG] = MIN_POS;
+float max_pos[NUM_LEGS][NUM_AXES_PER_LEG] = MAX_POS;
+float scale_fact[NUM_LEGS][NUM_AXES_PER_LEG] = SCALE_FACT;
 _Bool reverse_axis[NUM_LEGS][NUM_AXES_PER_LEG] = REVERSE_AXIS;
 
 /// Local enumeration for Cartesian dimensions
 enum Dimension { X = 0, Y = 1, Z = 2};
 
+/**
+ * @brief Keep the control interrupt out while axis setpoints are written
+ *
+ * With LEG_CONTROL_ISR the control step can preempt loop() at any point, so
+ * multi-word setpoints (a target with its feedforward, scalar_t targets in a
+ * HEX3_DOUBLE_PRECISION build) are
+ * written with interrupts off. No-op when control runs as a scheduler task.
+ */
+static inline uint32_t controlLock() {
+#if LEG_CONTROL_ISR
+    return save_and_disable_interrupts();
+#else
+    return 0;
+#endif
+}
+
+static inline void controlUnlock(uint32_t state) {
+#if LEG_CONTROL_ISR
+    restore_interrupts(state);
+#endif
+}
+
+#if LEG_CONTROL_ISR
+Leg* Leg::_control_leg = nullptr;
+#endif
+
 /**
  * @brief Constructor - Initialize leg to invalid state
  */
 Leg::Leg() {
     _leg_number = 0;
     can = nullptr;
+    for (uint8_t i = 0; i < NUM_AXES_PER_LEG; i++) {
+        _next_velocities[i] = 0.0f;
+        _next_accelerations[i] = 0.0f;
+    }
     // toe = Toe(); 
 }
 /**
  * @brief Initialize hardware - GPIO, multiplexer, and axis links
  *
- * Sets up the multiplexer and links each axis to its servo pins.
+ * Sets up the multiplexer, links each axis to its servo pins and starts the
+ * sensing task.
  * Pulse lines: [D11, D18, D16] are the PWM outputs
  * Direction lines: [D12, D2, D15] control motor direction
  * Also enables analog input for toe pressure sensor
  */
 void Leg::begin(){
-    mux.begin();
-    axes[0].link(D8, D10, 5, mux);
-    axes[1].link(D11, D12, D15, D16, 6, mux);
-    axes[2].link(D17, D18, 7, mux);
-    // toe.begin();
+#if LEG_KINEMATICS_BENCH || LOOP_PROFILER
+    cycleCounterBegin();
+#endif
+    scheduler.begin();
+    i2c_bus.begin();
+    mux.begin(i2c_bus);
+    axes[0].link(D8, D10, 5, mux, pwm);
+    axes[1].link(D11, D12, D15, D16, 6, mux, pwm);
+    axes[2].link(D17, D18, 7, mux, pwm);
+    pwm.start();
+    // toe.begin(i2c_bus);
+
+    // From here on the I2C bus and the ADC belong to the sensing task on core1
+    uint8_t encoder_channels[NUM_AXES_PER_LEG];
+    for (uint8_t i = 0; i < NUM_AXES_PER_LEG; i++) {
+        encoder_channels[i] = axes[i].getEncoderChannel();
+    }
+    sensing.begin(&i2c_bus, &mux, &toe, &voltage_sensor, encoder_channels);
+    _registerTasks();
+}
+
+/**
+ * @brief Start closed-loop control
+ *
+ * Call at the end of setup(), once control constants are set. Control then
+ * runs every LEG_CONTROL_INTERVAL_US: as the top priority scheduler task, or
+ * with LEG_CONTROL_ISR from a hardware alarm interrupt.
+ */
+void Leg::startControl() {
+#if LEG_CONTROL_ISR
+    _control_leg = this;
+    _control_alarm = hardware_alarm_claim_unused(true);
+    hardware_alarm_set_callback(_control_alarm, _controlAlarm);
+    irq_set_priority(hardware_alarm_get_irq_num(_control_alarm), PICO_HIGHEST_IRQ_PRIORITY);
+    _control_target_us = time_us_64() + LEG_CONTROL_INTERVAL_US;
+    hardware_alarm_set_target(_control_alarm, from_us_since_boot(_control_target_us));
+#else
+    scheduler.addTask("control", [](void* leg) { static_cast<Leg*>(leg)->runSpeed(); },
+        this, LEG_CONTROL_INTERVAL_US, 0, 0);
+#endif
+}
+
+#if LEG_CONTROL_ISR
+/**
+ * @brief Hardware alarm handler - one read-compute-write control cycle
+ *
+ * Re-arms first, against the previous target rather than the current time, so
+ * the rate does not drift with handler latency. If the next target has already
+ * passed the missed cycles are counted as overruns and skipped.
+ */
+void Leg::_controlAlarm(uint alarm_num) {
+    Leg* leg = _control_leg;
+    uint64_t entry_us = time_us_64();
+    uint32_t late_us = static_cast<uint32_t>(entry_us - leg->_control_target_us);
+
+    leg->_control_target_us += LEG_CONTROL_INTERVAL_US;
+    while (hardware_alarm_set_target(alarm_num, from_us_since_boot(leg->_control_target_us))) {
+        leg->_control_target_us += LEG_CONTROL_INTERVAL_US; // already in the past
+        leg->_control_timing.overruns++;
+    }
+
+    leg->_controlStep();
+
+    ControlTiming& timing = leg->_control_timing;
+    uint32_t exec_us = static_cast<uint32_t>(time_us_64() - entry_us);
+    if (timing.cycles > 0) {
+        uint32_t period_us = static_cast<uint32_t>(entry_us - leg->_control_last_entry_us);
+        if (period_us < timing.period_min_us) {
+            timing.period_min_us = period_us;
+        }
+        if (period_us > timing.period_max_us) {
+            timing.period_max_us = period_us;
+        }
+    }
+    if (late_us > timing.late_max_us) {
+        timing.late_max_us = late_us;
+    }
+    if (exec_us > timing.exec_max_us) {
+        timing.exec_max_us = exec_us;
+    }
+    timing.late_sum_us += late_us;
+    timing.cycles++;
+    leg->_control_last_entry_us = entry_us;
+}
+
+/**
+ * @brief Copy and reset the control interrupt timing
+ *
+ * @return false if the control interrupt is not enabled in this build
+ */
+bool Leg::readControlTiming(ControlTiming& timing) {
+    uint32_t state = controlLock();
+    timing = _control_timing;
+    _control_timing = ControlTiming();
+    controlUnlock(state);
+    return true;
+}
+#else
+bool Leg::readControlTiming(ControlTiming& timing) {
+    return false;
+}
+#endif
+
+/**
+ * @brief Print the control period jitter since the last call
+ */
+void Leg::printControlTiming() {
+    ControlTiming timing;
+    if (!readControlTiming(timing)) {
+        Serial.println("Control runs as a scheduler task (LEG_CONTROL_ISR off) - see scheduler stats");
+        return;
+    }
+    uint32_t mean_late_us = timing.cycles ? static_cast<uint32_t>(timing.late_sum_us / timing.cycles) : 0;
+    Serial.printf("Control ISR %lu us: cycles %lu overruns %lu | period min %lu max %lu us | entry late mean %lu max %lu us | exec max %lu us\n",
+        static_cast<uint32_t>(LEG_CONTROL_INTERVAL_US), timing.cycles, timing.overruns,
+        timing.cycles > 1 ? timing.period_min_us : 0, timing.period_max_us,
+        mean_late_us, timing.late_max_us, timing.exec_max_us);
+}
+
+/**
+ * @brief Print per-axis trajectory tracking error since the last call
+ *
+ * RMS and max position error while a trajectory fed the axis, and the mean lag
+ * (error over commanded velocity). Compare runs with AXIS_MODEL_FEEDFORWARD on
+ * and off to see what the model terms take off the velocity loop.
+ */
+void Leg::printTrackingError() {
+    TrackingStats stats[NUM_AXES_PER_LEG];
+    uint32_t state = controlLock();
+    for (uint8_t i = 0; i < NUM_AXES_PER_LEG; i++) {
+        stats[i] = axes[i].getTrackingStats();
+        axes[i].resetTrackingStats();
+    }
+    controlUnlock(state);
+
+    Serial.printf("Tracking error (model feedforward %s)\n", AXIS_MODEL_FEEDFORWARD ? "on" : "off");
+    for (uint8_t i = 0; i < NUM_AXES_PER_LEG; i++) {
+        float rms = stats[i].samples ? sqrtf(stats[i].error_sq_sum / stats[i].samples) : 0.0f;
+        float lag_ms = stats[i].lag_samples ? stats[i].lag_sum_s / stats[i].lag_samples * 1000.0f : 0.0f;
+        Serial.printf("Axis %d: %lu samples, rms %.2f mrad, max %.2f mrad | lag mean %.2f ms over %lu samples\n",
+            i, stats[i].samples, rms * 1000.0f, stats[i].error_max * 1000.0f, lag_ms, stats[i].lag_samples);
+    }
 }
 
 /**
@@ -66,7 +242,9 @@ void Leg::begin(){
 void Leg::initializeAxes(uint8_t leg_number) {
     _leg_number = leg_number;
     if (can == nullptr) {
-        can = new Can(1, 0, CanBitRate::BR_500k, leg_number, this);
+        // One leg per board: the bus object lives in static storage rather than on the heap
+        alignas(Can) static uint8_t can_storage[sizeof(Can)];
+        can = new (can_storage) Can(1, 0, CanBitRate::BR_500k, leg_number, this);
     }
     for (uint8_t i = 0; i < NUM_AXES_PER_LEG; i++) {
         axes[i].initializePositionLimits(min_pos[_leg_number][i], max_pos[_leg_number][i]);
@@ -75,92 +253,235 @@ void Leg::initializeAxes(uint8_t leg_number) {
 }
 
 /**
- * @brief Update motion tracking - position, velocity, and acceleration estimates
+ * @brief Update joint motion tracking from the latest sensor snapshot
  *
- * Called regularly to:
+ * Runs every control cycle:
+ * - Pick up the latest sensor snapshot from the sensing core
  * - Track axis motion through their trackMotion() methods
- * - Update Cartesian position using forward kinematics
- * - Calculate velocity and acceleration from position changes
- *
- * Uses separate update intervals for position (fast) and velocity (slower)
- * to reduce computational load.
+ * - Pass each axis' wanted encoder rate back to the sensing core
  */
 void Leg::_trackMotion() {
+    PROFILE_SECTION(PROFILE_TRACKING);
+    sensing.read(_sensors); // keeps the previous snapshot if the sensing core was mid-publish
     for (uint8_t j = 0; j < NUM_AXES_PER_LEG; j++) {
-        axes[j].trackMotion();
+        axes[j].trackMotion(_sensors.encoders[j]);
+        sensing.setEncoderPeriod(j, axes[j].getSamplePeriodUs());
     }
-    
-    // Update Cartesian position periodically using forward kinematics
-    if (millis() - _last_pos_update_time > LEG_POSITION_TRACK_INTERVAL_MS) {
-        _last_pos_update_time = millis();
-        // Calculate XYZ from joint angles
-        _forwardKinematics(axes[0].getCurrentPos(), axes[1].getCurrentPos(), axes[2].getCurrentPos(), 
-                          _current_pos[X], _current_pos[Y], _current_pos[Z]);
+}
+
+/**
+ * @brief Update the Cartesian state from the joint state
+ *
+ * Runs every LEG_POSITION_TRACK_INTERVAL_MS. Position comes from forward
+ * kinematics, velocity and acceleration from the joint observer's rates through
+ * the Jacobian: v = J qdot, a = J qddot + Jdot qdot.
+ */
+void Leg::_updateKinematics() {
+    scalar_t angles[NUM_AXES_PER_LEG], rates[NUM_AXES_PER_LEG], accelerations[NUM_AXES_PER_LEG];
+    for (uint8_t j = 0; j < NUM_AXES_PER_LEG; j++) {
+        angles[j] = axes[j].getCurrentPos();
+        rates[j] = axes[j].getCurrentVelocity();
+        accelerations[j] = axes[j].getCurrentAcceleration();
     }
-    
-    // Update velocity and acceleration (less frequently to improve stability)
-    if (millis() - _last_velocity_update_time > LEG_VELOCITY_TRACK_INTERVAL_MS) {
-        uint32_t delta_time = millis() - _last_velocity_update_time;
-        _last_velocity_update_time = millis();
-        
-        for (uint8_t j = 0; j < NUM_AXES_PER_LEG; j++) {
-            _last_velocity[j] = _current_velocity[j];
-            double distance_traversed = _current_pos[j] - _last_pos[j];
-            _current_velocity[j] = distance_traversed / (static_cast<double>(delta_time) / 1000.0); // units/s
-            _current_acceleration[j] = (_current_velocity[j] - _last_velocity[j]) / (static_cast<double>(delta_time) / 1000.0); // units/s^2
-            _last_pos[j] = _current_pos[j];
+    _forwardKinematics(angles[0], angles[1], angles[2], _current_pos[X], _current_pos[Y], _current_pos[Z]);
+
+    ThreeByThree jacobian;
+    _jacobian(angles, jacobian);
+    ThreeByOne velocity(rates);
+    velocity.mult_three_by_three(jacobian);
+    ThreeByOne acceleration(accelerations);
+    acceleration.mult_three_by_three(jacobian);
+    acceleration += _jacobianRateTerm(angles, rates);
+
+    // _forwardKinematics() reports z downward, the Jacobian works in the command frame (z up)
+    _current_velocity[X] = velocity.values[X];
+    _current_velocity[Y] = velocity.values[Y];
+    _current_velocity[Z] = -velocity.values[Z];
+    _current_acceleration[X] = acceleration.values[X];
+    _current_acceleration[Y] = acceleration.values[Y];
+    _current_acceleration[Z] = -acceleration.values[Z];
+}
+
+/**
+ * @brief Hold the current setpoint and run control
+ *
+ * Re-solves IK for the current Cartesian setpoint (picks up toe compression),
+ * or for the next point of a running linear move, curve segment or RAPID
+ * spline, and then, unless control runs from the control interrupt, does one
+ * _controlStep(). Registered by startControl() as the highest priority task.
+ */
+void Leg::runSpeed() {
+    {
+        PROFILE_SECTION(PROFILE_TOE);
+        _updateToe();
+    }
+    {
+        PROFILE_SECTION(PROFILE_IK);
+#if RAPID_INTERPOLATION
+        if (!linearMovePerform() && !_quadraticMovePerform() && !_rapidSplinePerform()) {
+#else
+        if (!linearMovePerform() && !_quadraticMovePerform()) {
+#endif
+            rapidMove(_current_cartesian[X], _current_cartesian[Y], _current_cartesian[Z]); // maintain current position if no new command
         }
     }
+#if !LEG_CONTROL_ISR
+    _controlStep();
+#endif
 }
 
 /**
- * @brief Main control loop - Execute PID, update motors, log telemetry, track motion
+ * @brief One read-compute-write control cycle
  *
- * Call this regularly (every 1-2ms) from your main loop. Performs:
- * - PID control for each axis to reach target position
- * - PWM signal generation through moveToPos()
+ * - Motion tracking from the latest encoder samples (joint position/velocity updates)
  * - Voltage feedback to motor controllers
- * - JSON telemetry logging every 10ms
- * - Motion tracking (position/velocity updates)
- *
- * The telemetry format is JSON with axis position, velocity, acceleration, duty cycle, and estimated torque.
+ * - PID control for each axis to reach target position
+ * - PWM levels staged by moveToPos(), latched together at the end
  */
-void Leg::runSpeed() {
-    static uint32_t last_print_time = 0;
-    _updateToe();
+void Leg::_controlStep() {
+    _trackMotion();
+    PROFILE_SECTION(PROFILE_PID);
+    for (uint8_t j = 0; j < NUM_AXES_PER_LEG; j++) {
+        axes[j].setInputVoltage(_sensors.voltage);
+        axes[j].moveToPos();
+    }
+    pwm.latch(); // all axes change on the same PWM period
+#if FLIGHT_RECORDER
+    _recordFlightSample();
+#endif
+}
 
-    
-    // Log telemetry every 10ms
-    if (millis() - last_print_time > 10) {
-        last_print_time = millis();
-#if TELEMETRY_LOGGING_SPACE == TELEMETRY_LOGGING_SPACE_CARTESIAN
-        Serial.printf("{\"Cartesian\": {\"pos\": [%f, %f, %f], \"vel\": [%f, %f, %f], \"acc\": [%f, %f, %f], \"duty\": [%f, %f, %f]}, \"voltage\": %f}\n",
-            _current_pos[X], _current_pos[Y], _current_pos[Z],
-            _current_velocity[X], _current_velocity[Y], _current_velocity[Z],
-            _current_acceleration[X], _current_acceleration[Y], _current_acceleration[Z],
-            axes[0].getDutyCycle(), axes[1].getDutyCycle(), axes[2].getDutyCycle(),
-            voltage_sensor.filteredRead());
+#if FLIGHT_RECORDER
+/**
+ * @brief Hand this control cycle's state to the flight recorder
+ */
+void Leg::_recordFlightSample() {
+    FlightRecorderSample sample;
+    sample.timestamp_us = micros();
+    for (uint8_t i = 0; i < NUM_AXES_PER_LEG; i++) {
+        sample.pos[i] = axes[i].getCurrentPos();
+        sample.vel[i] = axes[i].getCurrentVelocity();
+        sample.target[i] = axes[i].getTargetPos();
+        sample.duty[i] = axes[i].getDutyCycle();
+        sample.disturbance[i] = axes[i].getMOBDisturbanceTorque();
+    }
+    sample.toe = _sensors.toe;
+    recorder.record(sample);
+}
+
+void Leg::triggerOrArmRecorder() {
+    if (recorder.getState() == RECORDER_FROZEN) {
+        recorder.arm(recorder.getTriggerMask(), recorder.getDisturbanceThreshold());
+        Serial.println("Flight recorder re-armed");
+    }
+    else {
+        recorder.trigger(RECORDER_REASON_MANUAL);
+        Serial.println("Flight recorder triggered");
+    }
+}
+#endif
+
+/**
+ * @brief Log telemetry to serial
+ *
+ * Runs every LEG_TELEMETRY_INTERVAL_MS. The format is JSON with axis position,
+ * velocity, acceleration, duty cycle, and estimated torque, or with
+ * TELEMETRY_LOGGING_SPACE_BINARY one TelemetryRecord (telemetry_frame.hpp)
+ * carrying both joint and Cartesian state. Binary records are only queued
+ * here; drainTelemetry() frames and sends them.
+ */
+void Leg::_logTelemetry() {
+    PROFILE_SECTION(PROFILE_TELEMETRY);
+#if TELEMETRY_LOGGING_SPACE == TELEMETRY_LOGGING_SPACE_BINARY
+    TelemetryRecord record;
+    record.version = TELEMETRY_RECORD_VERSION;
+    record.leg = _leg_number;
+    record.sequence = _telemetry_sequence++;
+    record.timestamp_us = micros();
+    for (uint8_t i = 0; i < NUM_AXES_PER_LEG; i++) {
+        record.joint_pos[i] = axes[i].getCurrentPos();
+        record.joint_vel[i] = axes[i].getCurrentVelocity();
+        record.joint_acc[i] = axes[i].getCurrentAcceleration();
+        record.tracking_error[i] = axes[i].getTrackingError();
+        record.duty[i] = axes[i].getDutyCycle();
+        record.cartesian_pos[i] = static_cast<float>(_current_pos[i]);
+    }
+    record.voltage = _sensors.voltage;
+    record.toe = readToe();
+    telemetry.push(record);
+#elif TELEMETRY_LOGGING_SPACE == TELEMETRY_LOGGING_SPACE_CARTESIAN
+    Serial.printf("{\"Cartesian\": {\"pos\": [%f, %f, %f], \"vel\": [%f, %f, %f], \"acc\": [%f, %f, %f], \"duty\": [%f, %f, %f]}, \"voltage\": %f}\n",
+        _current_pos[X], _current_pos[Y], _current_pos[Z],
+        _current_velocity[X], _current_velocity[Y], _current_velocity[Z],
+        _current_acceleration[X], _current_acceleration[Y], _current_acceleration[Z],
+        axes[0].getDutyCycle(), axes[1].getDutyCycle(), axes[2].getDutyCycle(),
+        _sensors.voltage);
+#elif TELEMETRY_LOGGING_SPACE == TELEMETRY_LOGGING_SPACE_JOINT && AXIS_OBSERVER_BENCH
+    Serial.printf("{\"Joint\": {\"pos\": [%f, %f, %f], \"vel\": [%f, %f, %f], \"vel_legacy\": [%f, %f, %f], \"acc\": [%f, %f, %f], \"duty\": [%f, %f, %f]}, \"voltage\": %f, \"toe\": %f}\n",
+        axes[0].getCurrentPos(), axes[1].getCurrentPos(), axes[2].getCurrentPos(),
+        axes[0].getCurrentVelocity(), axes[1].getCurrentVelocity(), axes[2].getCurrentVelocity(),
+        axes[0].getLegacyVelocity(), axes[1].getLegacyVelocity(), axes[2].getLegacyVelocity(),
+        axes[0].getCurrentAcceleration(), axes[1].getCurrentAcceleration(), axes[2].getCurrentAcceleration(),
+        axes[0].getDutyCycle(), axes[1].getDutyCycle(), axes[2].getDutyCycle(),
+        _sensors.voltage, readToe());
 #elif TELEMETRY_LOGGING_SPACE == TELEMETRY_LOGGING_SPACE_JOINT
-        Serial.printf("{\"Joint\": {\"pos\": [%f, %f, %f], \"vel\": [%f, %f, %f], \"acc\": [%f, %f, %f], \"duty\": [%f, %f, %f]}, \"voltage\": %f, \"toe\": %f}\n",
-            axes[0].getCurrentPos(), axes[1].getCurrentPos(), axes[2].getCurrentPos(),
-            axes[0].getCurrentVelocity(), axes[1].getCurrentVelocity(), axes[2].getCurrentVelocity(),
-            axes[0].getCurrentAcceleration(), axes[1].getCurrentAcceleration(), axes[2].getCurrentAcceleration(),
-            axes[0].getDutyCycle(), axes[1].getDutyCycle(), axes[2].getDutyCycle(),
-            voltage_sensor.filteredRead(),readToe());
+    Serial.printf("{\"Joint\": {\"pos\": [%f, %f, %f], \"vel\": [%f, %f, %f], \"acc\": [%f, %f, %f], \"err\": [%f, %f, %f], \"duty\": [%f, %f, %f]}, \"voltage\": %f, \"toe\": %f}\n",
+        axes[0].getCurrentPos(), axes[1].getCurrentPos(), axes[2].getCurrentPos(),
+        axes[0].getCurrentVelocity(), axes[1].getCurrentVelocity(), axes[2].getCurrentVelocity(),
+        axes[0].getCurrentAcceleration(), axes[1].getCurrentAcceleration(), axes[2].getCurrentAcceleration(),
+        axes[0].getTrackingError(), axes[1].getTrackingError(), axes[2].getTrackingError(),
+        axes[0].getDutyCycle(), axes[1].getDutyCycle(), axes[2].getDutyCycle(),
+        _sensors.voltage, readToe());
 #elif TELEMETRY_LOGGING_SPACE != TELEMETRY_LOGGING_SPACE_NONE
-        Serial.printf("{\"Error\": \"Invalid TELEMETRY_LOGGING_SPACE value\"}\n");
+    Serial.printf("{\"Error\": \"Invalid TELEMETRY_LOGGING_SPACE value\"}\n");
 #endif
+}
+
+void Leg::drainTelemetry() {
+#if TELEMETRY_LOGGING_SPACE == TELEMETRY_LOGGING_SPACE_BINARY
+    telemetry.drain();
+#endif
+#if FLIGHT_RECORDER
+    while (Serial.availableForWrite() >= static_cast<int>(FRAME_SIZE(FLIGHT_RECORDER_CHUNK_SIZE))) {
+        uint8_t chunk[FLIGHT_RECORDER_CHUNK_SIZE];
+        uint16_t len = recorder.readChunk(RECORDER_DUMP_USB, chunk);
+        if (len == 0) {
+            break;
+        }
+        uint8_t frame[FRAME_SIZE(FLIGHT_RECORDER_CHUNK_SIZE)];
+        Serial.write(frame, encodeFrame(chunk, len, frame));
     }
-    
-    rapidMove(_current_cartesian[X], _current_cartesian[Y], _current_cartesian[Z]); // maintain current position if no new command
-    // Execute PID control and motor commands for all axes
-    for (uint8_t j = 0; j < NUM_AXES_PER_LEG; j++) {
-        axes[j].moveToPos();
-        axes[j].setInputVoltage(voltage_sensor.filteredRead());
-    }
-    
-    // Update motion tracking (kinematics, velocity estimates)
-    _trackMotion();
+#endif
+}
+
+/**
+ * @brief Register the leg's periodic work with the scheduler
+ *
+ * The control task is added later by startControl(); it also steps the
+ * trajectory, except with LEG_CONTROL_ISR where a trajectory task does. That
+ * and the command queue run first;
+ * everything that only feeds telemetry runs last and is
+ * phase-shifted so it does not land on the same tick as trajectory updates.
+ * Task context is the Leg.
+ */
+void Leg::_registerTasks() {
+#if LEG_CONTROL_ISR
+    // setpoints only, control itself is in the interrupt
+    scheduler.addTask("trajectory", [](void* leg) { static_cast<Leg*>(leg)->runSpeed(); },
+        this, LINEAR_MOVE_INTERVAL_MS * 1000, 0, 1);
+#endif
+    // polled faster than trajectory so timed commands start close to their time
+    scheduler.addTask("commands", [](void* leg) { static_cast<Leg*>(leg)->processCommandQueue(); },
+        this, COMMAND_QUEUE_POLL_INTERVAL_US, 0, 1);
+    scheduler.addTask("momentum", [](void* leg) {
+        for (uint8_t j = 0; j < NUM_AXES_PER_LEG; j++) {
+            static_cast<Leg*>(leg)->axes[j].momentumMonitor();
+        }
+    }, this, MOMENTUM_MONITOR_INTERVAL_MS * 1000, SCHEDULER_TICK_US, 2);
+    scheduler.addTask("kinematics", [](void* leg) { static_cast<Leg*>(leg)->_updateKinematics(); },
+        this, LEG_POSITION_TRACK_INTERVAL_MS * 1000, 2 * SCHEDULER_TICK_US, 3);
+    scheduler.addTask("telemetry", [](void* leg) { static_cast<Leg*>(leg)->_logTelemetry(); },
+        this, LEG_TELEMETRY_INTERVAL_MS * 1000, 3 * SCHEDULER_TICK_US, 4);
 }
 
 /**
@@ -174,7 +495,7 @@ void Leg::runSpeed() {
  * @param Ki_vel       Velocity loop integral gain
  * @param Kv_ff        Velocity feedforward gain
  */
-void Leg::setAxisControlConstants(uint8_t axis_number, double Kp_pos, double Kd_pos, double Kp_vel, double Ki_vel, double Kv_ff) {
+void Leg::setAxisControlConstants(uint8_t axis_number, float Kp_pos, float Kd_pos, float Kp_vel, float Ki_vel, float Kv_ff) {
     axes[axis_number].setControlConstants(Kp_pos, Kd_pos, Kp_vel, Ki_vel, Kv_ff);
 }
 
@@ -192,19 +513,120 @@ void Leg::setAxisControlConstants(uint8_t axis_number, double Kp_pos, double Kd_
  * @param[out] z Cartesian Z position (height) [mm]
  * @return Always true (no error checking in current implementation)
  */
-_Bool Leg::_forwardKinematics(double theta0, double theta1, double theta2, double& x, double& y, double& z) {
+_Bool Leg::_forwardKinematics(scalar_t theta0, scalar_t theta1, scalar_t theta2, scalar_t& x, scalar_t& y, scalar_t& z) {
     // Calculate distance in XY plane from vertical
-    double planar_distance = _length1 * cos(theta1) + _length2_dynamic * cos(theta1 + theta2) + _length0;
+    scalar_t planar_distance = _length1 * kinCos(theta1) + _length2_dynamic * kinCos(theta1 + theta2) + _length0;
     
     // Project planar distance to X,Y based on yaw angle
-    x = planar_distance * sin(theta0);
-    y = planar_distance * cos(theta0);
+    x = planar_distance * kinSin(theta0);
+    y = planar_distance * kinCos(theta0);
     
     // Calculate height (Z is measured downward from the hip)
-    z = -_length1 * sin(theta1) - _length2_dynamic * sin(theta1 + theta2);
+    z = -_length1 * kinSin(theta1) - _length2_dynamic * kinSin(theta1 + theta2);
+    return true;
+}
+
+/**
+ * @brief Analytic Jacobian of the toe position with respect to the joint angles
+ *
+ * In the command frame used by rapidMove() and _inverseKinematics() (z up):
+ *   x = p sin(t0), y = p cos(t0), z = L1 sin(t1) + L2 sin(t1 + t2)
+ *   p = L0 + L1 cos(t1) + L2 cos(t1 + t2)
+ * so with dp/dt1 = -z and dp/dt2 = -L2 sin(t1 + t2):
+ *
+ *       | p cos(t0)   dp/dt1 sin(t0)   dp/dt2 sin(t0) |
+ *   J = | -p sin(t0)  dp/dt1 cos(t0)   dp/dt2 cos(t0) |
+ *       | 0           p - L0           L2 cos(t1 + t2) |
+ *
+ * @param angles Joint angles [rad]
+ * @param[out] jacobian d(x, y, z)/d(t0, t1, t2) [mm/rad]
+ */
+void Leg::_jacobian(const scalar_t angles[NUM_AXES_PER_LEG], ThreeByThree& jacobian) {
+    scalar_t s0 = kinSin(angles[0]), c0 = kinCos(angles[0]);
+    scalar_t s1 = kinSin(angles[1]), c1 = kinCos(angles[1]);
+    scalar_t s12 = kinSin(angles[1] + angles[2]), c12 = kinCos(angles[1] + angles[2]);
+
+    scalar_t reach = _length1 * c1 + _length2_dynamic * c12;   // p - L0
+    scalar_t p = _length0 + reach;
+    scalar_t dp_dt1 = -_length1 * s1 - _length2_dynamic * s12;
+    scalar_t dp_dt2 = -_length2_dynamic * s12;
+
+    jacobian.values[0][0] = p * c0;
+    jacobian.values[0][1] = dp_dt1 * s0;
+    jacobian.values[0][2] = dp_dt2 * s0;
+    jacobian.values[1][0] = -p * s0;
+    jacobian.values[1][1] = dp_dt1 * c0;
+    jacobian.values[1][2] = dp_dt2 * c0;
+    jacobian.values[2][0] = 0.0f;
+    jacobian.values[2][1] = reach;
+    jacobian.values[2][2] = _length2_dynamic * c12;
+}
+
+/**
+ * @brief Closed-form inverse of the leg Jacobian
+ *
+ * The yaw row decouples: t0' = (x' cos(t0) - y' sin(t0)) / p. The remaining
+ * 2x2 block maps (p', z') to (t1', t2') and has determinant L1 L2 sin(t2).
+ *
+ * @param angles Joint angles [rad]
+ * @param[out] inverse d(t0, t1, t2)/d(x, y, z) [rad/mm]
+ * @return false if the leg is straight or the toe is on the yaw axis
+ */
+_Bool Leg::_jacobianInverse(const scalar_t angles[NUM_AXES_PER_LEG], ThreeByThree& inverse) {
+    scalar_t s0 = kinSin(angles[0]), c0 = kinCos(angles[0]);
+    scalar_t s1 = kinSin(angles[1]), c1 = kinCos(angles[1]);
+    scalar_t s2 = kinSin(angles[2]);
+    scalar_t s12 = kinSin(angles[1] + angles[2]), c12 = kinCos(angles[1] + angles[2]);
+
+    scalar_t reach = _length1 * c1 + _length2_dynamic * c12;
+    scalar_t p = _length0 + reach;
+    if (fabs(s2) < LEG_JACOBIAN_MIN_SIN_ELBOW || fabs(p) < LEG_JACOBIAN_MIN_REACH) {
+        return false;
+    }
+    scalar_t dp_dt1 = -_length1 * s1 - _length2_dynamic * s12;
+    scalar_t dp_dt2 = -_length2_dynamic * s12;
+    scalar_t dz_dt2 = _length2_dynamic * c12;
+    scalar_t inv_det = 1.0f / (_length1 * _length2_dynamic * s2);
+
+    inverse.values[0][0] = c0 / p;
+    inverse.values[0][1] = -s0 / p;
+    inverse.values[0][2] = 0.0f;
+    inverse.values[1][0] = dz_dt2 * s0 * inv_det;
+    inverse.values[1][1] = dz_dt2 * c0 * inv_det;
+    inverse.values[1][2] = -dp_dt2 * inv_det;
+    inverse.values[2][0] = -reach * s0 * inv_det;
+    inverse.values[2][1] = -reach * c0 * inv_det;
+    inverse.values[2][2] = dp_dt1 * inv_det;
     return true;
 }
 
+/**
+ * @brief Velocity-product part of the toe acceleration, Jdot * qdot
+ *
+ * a = J qddot + Jdot qdot. This is the second term: centripetal and Coriolis
+ * acceleration of the toe with the joints turning at constant rates.
+ *
+ * @param angles Joint angles [rad]
+ * @param rates Joint rates [rad/s]
+ * @return Toe acceleration in the command frame [mm/s^2]
+ */
+ThreeByOne Leg::_jacobianRateTerm(const scalar_t angles[NUM_AXES_PER_LEG], const scalar_t rates[NUM_AXES_PER_LEG]) {
+    scalar_t s0 = kinSin(angles[0]), c0 = kinCos(angles[0]);
+    scalar_t s1 = kinSin(angles[1]), c1 = kinCos(angles[1]);
+    scalar_t s12 = kinSin(angles[1] + angles[2]), c12 = kinCos(angles[1] + angles[2]);
+
+    scalar_t p = _length0 + _length1 * c1 + _length2_dynamic * c12;
+    scalar_t rate12 = rates[1] + rates[2];
+    scalar_t p_rate = -_length1 * s1 * rates[1] - _length2_dynamic * s12 * rate12;
+    // p'' and z'' with zero joint acceleration
+    scalar_t p_accel = -_length1 * c1 * rates[1] * rates[1] - _length2_dynamic * c12 * rate12 * rate12;
+    scalar_t z_accel = -_length1 * s1 * rates[1] * rates[1] - _length2_dynamic * s12 * rate12 * rate12;
+
+    return ThreeByOne(p_accel * s0 + 2.0f * p_rate * c0 * rates[0] - p * s0 * rates[0] * rates[0],
+                      p_accel * c0 - 2.0f * p_rate * s0 * rates[0] - p * c0 * rates[0] * rates[0],
+                      z_accel);
+}
+
 /**
  * @brief Calculate joint angles from Cartesian position (inverse kinematics)
  *
@@ -220,44 +642,44 @@ _Bool Leg::_forwardKinematics(double theta0, double theta1, double theta2, doubl
  * @note On successful solution, _next_angles will contain the target joint angles.
  *       If the position is out of joint limits, the computed angles are still stored.
  */
-_Bool Leg::_inverseKinematics(double x, double y, double z) {
+_Bool Leg::_inverseKinematics(scalar_t x, scalar_t y, scalar_t z) {
 
     // Validate coordinates are reachable
     if (!_checkSafeCoords(x, y, z))
         return false; 
         
-    double potential_results[3];
+    scalar_t potential_results[3];
     
     // Calculate theta0 (yaw angle)
     // Special handling for coordinates near y=0 to avoid division issues
-    if (fabs(y < 0.1)) {
-        if (x > 0.1) {
-            potential_results[0] = M_PI / 2.0;
+    if (fabs(y < 0.1f)) {
+        if (x > 0.1f) {
+            potential_results[0] = SCALAR_PI / 2.0f;
         }
-        else if (x < -0.1) {
-            potential_results[0] = -M_PI / 2.0;
+        else if (x < -0.1f) {
+            potential_results[0] = -SCALAR_PI / 2.0f;
         }
         else {
             potential_results[0] = 0;
         }
     }  
     else {
-        potential_results[0] = atan2(x, y);
+        potential_results[0] = kinAtan2(x, y);
     }
 
     // Calculate effective planar distance
-    double y_virtual_planar = sqrt(y * y + x * x) - _length0;
-    double planar_distance = sqrt(y_virtual_planar * y_virtual_planar + z * z);
+    scalar_t y_virtual_planar = kinSqrt(y * y + x * x) - _length0;
+    scalar_t planar_distance = kinSqrt(y_virtual_planar * y_virtual_planar + z * z);
     
     // Use law of cosines to calculate theta2 (elbow angle)
-    double theta2_tool = (planar_distance*planar_distance - _length1*_length1 - _length2_dynamic*_length2_dynamic)
+    scalar_t theta2_tool = (planar_distance*planar_distance - _length1*_length1 - _length2_dynamic*_length2_dynamic)
                         / (2 * _length1 * _length2_dynamic);
 
-    potential_results[2] = atan2(sqrt(1 - (theta2_tool*theta2_tool)), theta2_tool);
+    potential_results[2] = kinAtan2(kinSqrt(1 - (theta2_tool*theta2_tool)), theta2_tool);
     
     // Calculate theta1 (shoulder angle)
-    double theta1_tool0 = atan2(z, y_virtual_planar);
-    double theta1_tool1 = atan2(_length2_dynamic * sin(potential_results[2]), _length1 + _length2_dynamic * cos(potential_results[2]));
+    scalar_t theta1_tool0 = kinAtan2(z, y_virtual_planar);
+    scalar_t theta1_tool1 = kinAtan2(_length2_dynamic * kinSin(potential_results[2]), _length1 + _length2_dynamic * kinCos(potential_results[2]));
     potential_results[1] = theta1_tool0 - theta1_tool1;
     
     // Adjust angles for negative Z (target below the shoulder plane)
@@ -298,7 +720,7 @@ _Bool Leg::_inverseKinematics(double x, double y, double z) {
  * @param z Cartesian Z coordinate [mm]
  * @return true if coordinates are safe, false if collision detected
  */
-_Bool Leg::_checkSafeCoords(double x, double y, double z) {
+_Bool Leg::_checkSafeCoords(scalar_t x, scalar_t y, scalar_t z) {
     // TODO: Implement collision checking with hexapod body
     return true;
 }
@@ -318,8 +740,15 @@ _Bool Leg::_checkSafeCoords(double x, double y, double z) {
  * @note Does not update _moving_flag. Call this repeatedly if continuous motion is needed.
  *       Use linearMoveSetup() for coordinated motion with velocity control.
  */
-_Bool Leg::rapidMove(double x,  double y, double z) {
+_Bool Leg::rapidMove(scalar_t x,  scalar_t y, scalar_t z) {
+#if LEG_KINEMATICS_BENCH
+    uint32_t start = cycleCount();
+    _Bool solved = _inverseKinematics(x, y, z);
+    _ik_cycles.add(cycleCount() - start);
+    if (solved) {
+#else
     if (_inverseKinematics(x, y, z)) {
+#endif
         _moveAxes();
         _current_cartesian[0] = x;
         _current_cartesian[1] = y;
@@ -334,123 +763,213 @@ _Bool Leg::rapidMove(ThreeByOne target_pos) {
 }
 
 /**
- * @brief Execute one iteration of a linear move with acceleration profile
+ * @brief Execute one control step of a linear move
  *
- * Must be called regularly (every 1-5ms) after linearMoveSetup().
- * Implements a three-phase motion profile:
- *   1. ACCELERATING: Linear ramp up to target speed
+ * Samples the move's S-curve profile at the current time, so the setpoint is
+ * where the profile puts it rather than an integral of past steps. Phases:
+ *   1. ACCELERATING: jerk up to MAX_LINEAR_ACCELERATION, hold, jerk down at the cruise speed
  *   2. CRUISING: Constant velocity motion
- *   3. DECELERATING: Linear ramp down to zero
+ *   3. DECELERATING: the acceleration phase mirrored, ending at rest on the target
+ *
+ * While a queued move is blending in (see _blendLinearMove()) its
+ * displacement is added, and it takes over once this one is done.
  *
- * Each phase uses trapezoidal velocity profile with MAX_LINEAR_ACCELERATION.
+ * Called by runSpeed() every control step (every LINEAR_MOVE_INTERVAL_MS with
+ * LEG_CONTROL_ISR).
  *
- * @return 1 if move is active/progressing, 0 if move not active or move interval not yet elapsed
+ * @return 1 if move is active/progressing, 0 if move not active
  *
- * @note Updates position targets continuously using inverse kinematics.
- *       Sets feedforward velocity on axes for smooth control.
- *       Call until return value is 0 to complete the move.
+ * @note Updates position targets using inverse kinematics and sets the joint
+ *       feedforward from the profile's speed and acceleration.
  */
 uint8_t Leg::linearMovePerform() {
-    uint32_t delta = millis() - _last_linear_move_time;
-    
-    if (delta >= LINEAR_MOVE_INTERVAL_MS) {
-        _last_linear_move_time = millis();
-        
-        if (_move_stage == move_stage::ACCELERATING || _move_stage == move_stage::CRUISING || _move_stage == move_stage::DECELERATING) {
-            double move_progress;
-            
-            // Calculate progress through current phase (0.0 to 1.0)
-            switch(_move_stage) {
-                case ACCELERATING:
-                    move_progress = (float)(millis() - _move_start_time) / ((float) _accel_time);
-                    break;
-                case CRUISING:
-                    move_progress = (float)(millis() - _move_start_time - _accel_time) / ((float) (_move_time - 2 * _accel_time));
-                    break;
-                case DECELERATING:
-                    move_progress = (float)(millis() - _move_start_time - _move_time + _accel_time) / ((float) _accel_time);
-                    break;
-                default:
-                    move_progress = 0.0;
-                    break;
-            }
-            
-            if (move_progress <= 1.0) {
-                // Calculate current speed based on phase
-                switch(_move_stage) {
-                    case ACCELERATING:
-                        _last_speed = move_progress * _target_speed;
-                        break;
-                    case CRUISING:
-                        _last_speed = _target_speed;
-                        break;
-                    case DECELERATING:
-                        _last_speed = (1.0 - move_progress) * _target_speed;
-                        break;
-                    default:
-                        _last_speed = 0.0;
-                        break;
-                }
-                
-                // Calculate next position target along the direction vector
-                ThreeByOne next_pos = _direction_vector * _last_speed * (static_cast<double>(delta) / 1000.0) + ThreeByOne(_current_cartesian); 
-                
-                _moving_flag = true;
-                
-                // Get current axis states
-                for (uint8_t i = 0; i < NUM_AXES_PER_LEG; i++) {
-                    _current_angles[i] = axes[i].getCurrentPos();
-                    _current_velocities[i] = axes[i].getCurrentVelocity(); 
-                }
-                
-                // Move to next position via inverse kinematics
-                rapidMove(next_pos); //updates _next_angles
-                
-                // Calculate required velocities and set as feedforward
-                for (uint8_t i = 0; i < NUM_AXES_PER_LEG; i++) {
-                    double next_velocity = (_next_angles[i] - _current_angles[i]) / (static_cast<double>(delta) / 1000.0);
-                    double next_acceleration = (next_velocity - _current_velocities[i]) / (static_cast<double>(delta) / 1000.0);
-                    axes[i].setFeedforwardVelocity(next_velocity); //rad/s
-                }
-            }
-            else {
-                // Transition to next phase or complete move
-                switch(_move_stage) {
-                    case ACCELERATING:
-                        _move_stage = CRUISING;
-                        break;
-                    case CRUISING:
-                        _move_stage = DECELERATING;
-                        break;
-                    case DECELERATING:
-                        // Motion complete
-                        for (uint8_t i = 0; i < NUM_AXES_PER_LEG; i++) {
-                            axes[i].setFeedforwardVelocity(0.0);
-                        }
-                        
-                        _move_stage = STOPPED;
-                        break;
-                    default:
-                        break;
-                }
-                
-                // Final position adjustment after deceleration
-                if (_moving_flag && _move_stage == STOPPED) {
-                    rapidMove(_end_cartesian[0], _end_cartesian[1], _end_cartesian[2]);
-                }
-            }
-            return 1;
+    PROFILE_SECTION(PROFILE_LINEAR_MOVE);
+    if (_move_stage != move_stage::ACCELERATING && _move_stage != move_stage::CRUISING && _move_stage != move_stage::DECELERATING) {
+        return 0;
+    }
+#if LEG_KINEMATICS_BENCH
+    uint32_t start_cycles = cycleCount();
+#endif
+    scalar_t distance, speed, acceleration;
+    SCurvePhase phase = _linear_profile.sample(static_cast<scalar_t>(micros() - _move_start_us) * 1e-6f,
+                                               distance, speed, acceleration);
+    TrajectoryPoint point;
+    point.pos = ThreeByOne(_start_cartesian) + _direction_vector * distance;
+    point.vel = _direction_vector * speed;
+    point.acc = _direction_vector * acceleration;
+    if (_blend_active) {
+        // the next move starts from this one's target, its displacement so far adds on
+        _blend_profile.sample(static_cast<scalar_t>(micros() - _blend_start_us) * 1e-6f, distance, speed, acceleration);
+        point.pos += _blend_direction * distance;
+        point.vel += _blend_direction * speed;
+        point.acc += _blend_direction * acceleration;
+    }
+    _followTrajectoryPoint(point);
+
+    if (phase == SCURVE_DONE && _blend_active) {
+        // hand over: the next move carries on alone from this one's target
+        for (uint8_t i = 0; i < NUM_AXES_PER_LEG; i++) {
+            _start_cartesian[i] = _end_cartesian[i];
+            _end_cartesian[i] = _blend_end[i];
         }
+        _direction_vector = _blend_direction;
+        _linear_profile = _blend_profile;
+        _move_start_us = _blend_start_us;
+        _blend_active = false;
+        phase = _linear_profile.sample(static_cast<scalar_t>(micros() - _move_start_us) * 1e-6f, distance, speed, acceleration);
     }
-    return 0;
+
+    switch (phase) {
+        case SCURVE_ACCELERATING:
+            _move_stage = ACCELERATING;
+            break;
+        case SCURVE_CRUISING:
+            _move_stage = CRUISING;
+            break;
+        case SCURVE_DECELERATING:
+            _move_stage = DECELERATING;
+            break;
+        case SCURVE_DONE:
+            // last sample is the target itself, at rest
+            _move_stage = STOPPED;
+            _moving_flag = false;
+            break;
+    }
+#if LEG_KINEMATICS_BENCH
+    _linear_move_cycles.add(cycleCount() - start_cycles);
+#endif
+    return 1;
+}
+
+/**
+ * @brief Joint velocity and acceleration feedforward for a Cartesian trajectory
+ *
+ * qdot = J^-1 v, qddot = J^-1 (a - Jdot qdot), evaluated at _next_angles (the
+ * setpoint just solved by rapidMove()). _current_angles must hold the measured
+ * angles for the fallback near a singularity.
+ *
+ * @param velocity     Toe velocity (mm/s)
+ * @param acceleration Toe acceleration (mm/s^2)
+ * @param step_s       Time since the previous setpoint, for the fallback
+ */
+void Leg::_setCartesianFeedforward(ThreeByOne velocity, ThreeByOne acceleration, scalar_t step_s) {
+    ThreeByThree inverse;
+    if (_jacobianInverse(_next_angles, inverse)) {
+        velocity.mult_three_by_three(inverse);
+        ThreeByOne joint_acceleration = acceleration - _jacobianRateTerm(_next_angles, velocity.values);
+        joint_acceleration.mult_three_by_three(inverse);
+        for (uint8_t i = 0; i < NUM_AXES_PER_LEG; i++) {
+            _next_velocities[i] = velocity.values[i];
+            _next_accelerations[i] = joint_acceleration.values[i];
+        }
+    }
+    else {
+        // J^-1 blows up at a singularity, difference the IK solution instead
+        for (uint8_t i = 0; i < NUM_AXES_PER_LEG; i++) {
+            _next_velocities[i] = (_next_angles[i] - _current_angles[i]) / step_s;
+            _next_accelerations[i] = 0.0f;
+        }
+    }
+    uint32_t state = controlLock();
+    for (uint8_t i = 0; i < NUM_AXES_PER_LEG; i++) {
+        axes[i].setFeedforwardVelocity(_next_velocities[i]); //rad/s
+        axes[i].setFeedforwardAcceleration(_next_accelerations[i]); //rad/s^2
+    }
+    controlUnlock(state);
+}
+
+/**
+ * @brief Start a quadratic Bézier segment from the current position
+ *
+ * Ends any linear move. The segment is then followed by runSpeed() every
+ * control step until it has run for duration_ms, then end is held. The toe
+ * still has the curve's end velocity there, so a swing is normally chained
+ * into the next segment or shaped to arrive slowly.
+ *
+ * @param control  Bézier control point [mm], or with through set a point the curve passes at half time
+ * @param end      Target position [mm]
+ * @param duration_ms Time for the whole segment
+ * @param start_us micros() the segment is timed from, normally now or the command's execute time
+ * @return false if the end point is unreachable (the leg keeps its position)
+ */
+_Bool Leg::quadraticMoveSetup(const scalar_t control[NUM_AXES_PER_LEG], const scalar_t end[NUM_AXES_PER_LEG],
+                              uint32_t duration_ms, uint32_t start_us, _Bool through) {
+    if (!_checkSafeCoords(end[X], end[Y], end[Z])) {
+        return false;
+    }
+    _move_stage = move_stage::STOPPED;
+    _moving_flag = false;
+    _blend_active = false;
+#if RAPID_INTERPOLATION
+    _rapid_spline.reset();
+#endif
+    _curve.start(_current_cartesian, control, end, duration_ms * 1000, start_us, through);
+    return true;
+}
+
+/**
+ * @brief One control-rate step of the curve segment
+ *
+ * A point that fails IK ends the segment where the leg is, rather than
+ * skipping ahead along an unreachable stretch.
+ */
+_Bool Leg::_quadraticMovePerform() {
+    if (!_curve.isActive()) {
+        return false;
+    }
+    TrajectoryPoint point;
+    _curve.evaluate(micros(), point); // the last sample is the end point at rest
+    if (!_followTrajectoryPoint(point)) {
+        _curve.stop();
+    }
+    return true;
+}
+
+#if RAPID_INTERPOLATION
+/**
+ * @brief One control-rate step along the RAPID setpoint spline
+ *
+ * Trails the received setpoints by RAPID_INTERPOLATION_DELAY_US. An
+ * unreachable point is skipped, the next setpoint may be fine again.
+ */
+_Bool Leg::_rapidSplinePerform() {
+    TrajectoryPoint point;
+    if (!_rapid_spline.evaluate(micros(), RAPID_INTERPOLATION_DELAY_US, point)) {
+        return false;
+    }
+    _followTrajectoryPoint(point);
+    return true;
+}
+#endif
+
+_Bool Leg::_followTrajectoryPoint(const TrajectoryPoint& point) {
+    for (uint8_t i = 0; i < NUM_AXES_PER_LEG; i++) {
+        _current_angles[i] = axes[i].getCurrentPos();
+    }
+    if (rapidMove(point.pos)) {
+#if LEG_CONTROL_ISR
+        _setCartesianFeedforward(point.vel, point.acc, LINEAR_MOVE_INTERVAL_MS * 1e-3f); // runSpeed() runs from the trajectory task
+#else
+        _setCartesianFeedforward(point.vel, point.acc, LEG_CONTROL_INTERVAL_US * 1e-6f);
+#endif
+        return true;
+    }
+    uint32_t state = controlLock();
+    for (uint8_t i = 0; i < NUM_AXES_PER_LEG; i++) {
+        axes[i].setFeedforwardVelocity(0.0f);
+        axes[i].setFeedforwardAcceleration(0.0f);
+    }
+    controlUnlock(state);
+    return false;
 }
 
 /**
  * @brief Initialize a linear move from current position to target with velocity profile
  *
- * Calculates motion timing to reach the target position with smooth acceleration,
- * constant velocity, and deceleration phases. Must call linearMovePerform() repeatedly
- * after this to execute the motion.
+ * Plans a jerk-limited S-curve along the straight line to the target, limited
+ * by target_speed, MAX_LINEAR_ACCELERATION and MAX_LINEAR_JERK. If the move is
+ * too short to reach target_speed the peak speed is lowered to fit. Ends any
+ * curve segment or RAPID spline.
  *
  * @param x Target X position [mm]
  * @param y Target Y position [mm]
@@ -459,15 +978,13 @@ uint8_t Leg::linearMovePerform() {
  * @param relative If true, target is relative to current position (NOT IMPLEMENTED)
  * @return 0 if successful, 1 if requested speed exceeds _max_speed (will be capped)
  *
- * @note After calling this, repeatedly call linearMovePerform() until it returns 0.
- *       The motion uses MAX_LINEAR_ACCELERATION for both accel and decel phases.
- *       If total distance is small, acceleration phase is shortened to fit.
+ * @note runSpeed() then follows the move through linearMovePerform() until it is done.
  */
-_Bool Leg::linearMoveSetup(double x,  double y, double z, double target_speed, _Bool relative) {
+_Bool Leg::linearMoveSetup(scalar_t x,  scalar_t y, scalar_t z, scalar_t target_speed, _Bool relative) {
     uint8_t retval = 0;
     
     // Cap speed to maximum allowed
-    double speed = target_speed;
+    scalar_t speed = target_speed;
     if (target_speed > _max_speed) {
         speed = _max_speed;
         retval = 1; // return warning that speed was capped
@@ -482,45 +999,24 @@ _Bool Leg::linearMoveSetup(double x,  double y, double z, double target_speed, _
     _end_cartesian[0] = x;
     _end_cartesian[1] = y;
     _end_cartesian[2] = z;
-    
-    // Calculate total distance to travel
-    _move_start_time = millis();
+
+    _curve.stop();
+#if RAPID_INTERPOLATION
+    _rapid_spline.reset();
+#endif
+
+    ThreeByOne travel(_end_cartesian[0] - _start_cartesian[0],
+                      _end_cartesian[1] - _start_cartesian[1],
+                      _end_cartesian[2] - _start_cartesian[2]);
+    scalar_t total_dist = travel.magnitude();
+    // a zero length move still runs (one sample) and lands exactly on the target
+    _direction_vector = total_dist > 0.0f ? travel / total_dist : ThreeByOne(0.0f, 0.0f, 0.0f);
+    _linear_profile.plan(total_dist, speed, MAX_LINEAR_ACCELERATION, MAX_LINEAR_JERK);
+
+    _move_start_us = micros();
     _moving_flag = true;
-    double x_dist = _start_cartesian[0] - _end_cartesian[0];
-    double y_dist = _start_cartesian[1] - _end_cartesian[1];
-    double z_dist = _start_cartesian[2] - _end_cartesian[2];
-    double total_dist = sqrt(x_dist*x_dist + y_dist*y_dist + z_dist*z_dist);
-    
-    // Calculate acceleration phase timing
-    double accel_time_s = speed / MAX_LINEAR_ACCELERATION;
-    double accel_distance = 0.5 * MAX_LINEAR_ACCELERATION * accel_time_s * accel_time_s;
-    double move_time_s;
-    
-    // If move is very short, shorten acceleration phase to fit
-    if (total_dist < 2.0 * accel_distance) {
-        accel_distance = total_dist / 2.0;
-        accel_time_s = sqrt(2.0 * accel_distance / MAX_LINEAR_ACCELERATION);
-        move_time_s = 2 * accel_time_s;  // Total time = accel + decel only
-        _target_speed = accel_time_s * MAX_LINEAR_ACCELERATION; // Peak speed achieved
-    }
-    else {
-        // Standard trapezoidal profile
-        move_time_s = 
-            ((total_dist - (2 * accel_distance)) / speed   // Constant speed phase time
-            + (2 * speed) / MAX_LINEAR_ACCELERATION);       // Accel + decel time
-        _target_speed = speed;
-    }
-    
-    _last_speed = 0.0;
+    _blend_active = false;
     _move_stage = move_stage::ACCELERATING;
-    _accel_time = static_cast<uint32_t>(accel_time_s * 1000.0);
-    _move_time = static_cast<uint32_t>(move_time_s * 1000.0);
-
-    // Calculate direction vector (normalized)
-    _direction_vector = ThreeByOne(_end_cartesian[0] - _start_cartesian[0], 
-                                   _end_cartesian[1] - _start_cartesian[1], 
-                                   _end_cartesian[2] - _start_cartesian[2]).unit_vector();
-     
     return retval;
 }
 
@@ -531,45 +1027,159 @@ _Bool Leg::linearMoveSetup(double x,  double y, double z, double target_speed, _
  * to both the axis setpoints and the public current_angles[] array.
  */
 void Leg::_moveAxes() {
+    uint32_t state = controlLock();
     for (uint8_t i = 0; i < NUM_AXES_PER_LEG; i++) {
         axes[i].setTargetPos(_next_angles[i]);
         current_angles[i] = _next_angles[i];
     }
+    controlUnlock(state);
 }
 
-void Leg::setAxisTargetPos(uint8_t axis_number, double pos) {
+void Leg::setAxisTargetPos(uint8_t axis_number, scalar_t pos) {
+    uint32_t state = controlLock();
     axes[axis_number].setTargetPos(pos);
+    controlUnlock(state);
 }
 
 void Leg::stopAxis(uint8_t axis_number) {
+    uint32_t state = controlLock();
     axes[axis_number].allowMotion(false);
+    controlUnlock(state);
 }
 
+/**
+ * @brief Corner blending between consecutive linear moves
+ *
+ * Looked at while cmd, a linear move whose execute time (if any) has come,
+ * waits at the head of the queue for the running linear move. It is planned from the running move's target,
+ * and started once that move is within the overlap given by
+ * sCurveBlendOverlap() for LINEAR_BLEND_TOLERANCE of its end. The two
+ * profiles then run together, so the toe keeps moving through the corner and
+ * passes within about LINEAR_BLEND_TOLERANCE of it; moves in nearly the
+ * same direction overlap fully and keep their cruise speed. Only one move
+ * blends in at a time; the one after waits until this one has taken over.
+ *
+ * @return true if cmd has been started and should be taken off the queue
+ */
+_Bool Leg::_blendLinearMove(const Command& cmd, uint32_t now_us) {
+    if (LINEAR_BLEND_TOLERANCE <= 0.0f || _blend_active || _curve.isActive()) {
+        return false;
+    }
+    ThreeByOne travel(cmd.linear_move.x - _end_cartesian[0],
+                      cmd.linear_move.y - _end_cartesian[1],
+                      cmd.linear_move.z - _end_cartesian[2]);
+    scalar_t length = travel.magnitude();
+    scalar_t speed = cmd.linear_move.speed < _max_speed ? cmd.linear_move.speed : _max_speed;
+    ThreeByOne direction = length > 0.0f ? travel / length : ThreeByOne(0.0f, 0.0f, 0.0f);
+    SCurveProfile next;
+    next.plan(length, speed, MAX_LINEAR_ACCELERATION, MAX_LINEAR_JERK);
+
+    // the toe misses the corner by about reach * sin(turn); past 90 degrees the
+    // moves oppose each other and the full tolerance is the limit, near 0 a
+    // metre of reach means no limit
+    scalar_t turn_cos = _direction_vector.values[0] * direction.values[0]
+                      + _direction_vector.values[1] * direction.values[1]
+                      + _direction_vector.values[2] * direction.values[2];
+    scalar_t turn_sin = turn_cos > 0.0f ? sqrt(1.0f - turn_cos * turn_cos) : 1.0f;
+    scalar_t reach = turn_sin * 1000.0f > LINEAR_BLEND_TOLERANCE ? LINEAR_BLEND_TOLERANCE / turn_sin : 1000.0f;
+    scalar_t overlap = sCurveBlendOverlap(_linear_profile, next, reach);
+    scalar_t remaining = _linear_profile.duration() - static_cast<scalar_t>(now_us - _move_start_us) * 1e-6f;
+    if (overlap <= 0.0f || remaining > overlap) {
+        return false;
+    }
+
+    // from here on cmd is started, the current move carries on underneath it
+    _blend_profile = next;
+    _blend_direction = direction;
+    _blend_end[0] = cmd.linear_move.x;
+    _blend_end[1] = cmd.linear_move.y;
+    _blend_end[2] = cmd.linear_move.z;
+    _blend_start_us = now_us;
+    _blend_active = true;
+    return true;
+}
+
+_Bool Leg::_moveActive() {
+    return _move_stage == move_stage::ACCELERATING || _move_stage == move_stage::CRUISING
+        || _move_stage == move_stage::DECELERATING || _curve.isActive();
+}
+
+/**
+ * @brief Start the next queued command once it is due
+ *
+ * Every command waits for the running linear move or curve to finish, so a
+ * stream of them plays back in sequence - except that a linear move
+ * following a linear move starts a little early and rounds the corner
+ * (_blendLinearMove()). execute_at_us is a "not before" time on top of that:
+ * a timed command also waits for micros() to reach it, and if the leg is
+ * idle by then it starts on schedule, which is what lets a group of legs
+ * start together. Commands always start in arrival order.
+ */
 void Leg::processCommandQueue()
 {
-    /*
-    if (!isReadyForNextCommand()) //TODO - talk to Zack
+    PROFILE_SECTION(PROFILE_COMMAND_QUEUE);
+    Command cmd;
+    if (!command_queue.peek(0, cmd))
     {
         return;
     }
-    */
+    _Bool blended = false;
+    uint32_t now = micros();
 
-    Command cmd;
-    if (!command_queue.dequeue(cmd))
+    if (cmd.execute_at_us != 0 && !command_queue.isDue(now))
     {
         return;
     }
+    if (_moveActive())
+    {
+        blended = cmd.type == CommandType::LinearMove && _blendLinearMove(cmd, now);
+        if (!blended)
+        {
+            _command_held = cmd.execute_at_us != 0;
+            return;
+        }
+    }
+
+    // on schedule if it found the leg idle, otherwise it starts from now; only
+    // the former says anything about sync or poll jitter, so only it counts as late
+    uint32_t start_us = now;
+    if (cmd.execute_at_us != 0)
+    {
+        if (_command_held || blended)
+        {
+            command_queue.recordHeldStart();
+        }
+        else
+        {
+            uint32_t late_us = now - cmd.execute_at_us;
+            command_queue.recordTimedStart(late_us);
+            if (late_us <= COMMAND_LATE_THRESHOLD_US)
+            {
+                start_us = cmd.execute_at_us;
+            }
+        }
+    }
+    _command_held = false;
+
+    command_queue.dequeue(cmd);
+#if FLIGHT_RECORDER
+    recorder.notifyCommand();
+#endif
 
     switch (cmd.type)
     {
         case CommandType::SingleAxisMove:
         {
-            axes[cmd.single_axis.axis].setTargetPos(cmd.single_axis.position);
+            setAxisTargetPos(cmd.single_axis.axis, cmd.single_axis.position);
             break;
         }
 
         case CommandType::LinearMove:
         {
+            if (blended)
+            {
+                break;              // already started by _blendLinearMove()
+            }
             linearMoveSetup(
                 cmd.linear_move.x,
                 cmd.linear_move.y,
@@ -577,18 +1187,37 @@ void Leg::processCommandQueue()
                 cmd.linear_move.speed,
                 false
             );
+            _move_start_us = start_us;     // the profile runs on schedule even if the poll started it late
             break;
         }
 
         case CommandType::QuadraticMove:
         {
-            // TODO
+            scalar_t control[NUM_AXES_PER_LEG] = {cmd.quadratic_move.control[0], cmd.quadratic_move.control[1], cmd.quadratic_move.control[2]};
+            scalar_t end[NUM_AXES_PER_LEG] = {cmd.quadratic_move.end[0], cmd.quadratic_move.end[1], cmd.quadratic_move.end[2]};
+            // a timed segment keeps its schedule even when the queue poll starts it late
+            quadraticMoveSetup(
+                control,
+                end,
+                cmd.quadratic_move.duration_ms,
+                start_us,
+                cmd.quadratic_move.through
+            );
             break;
         }
 
         case CommandType::RapidMove:
         {
+            _curve.stop();
+#if RAPID_INTERPOLATION
+            // sampled at its arrival (or scheduled) time, runSpeed() follows the spline through it
+            _move_stage = move_stage::STOPPED;
+            _blend_active = false;
+            scalar_t setpoint[NUM_AXES_PER_LEG] = {cmd.rapid_move.x, cmd.rapid_move.y, cmd.rapid_move.z};
+            _rapid_spline.push(setpoint, cmd.execute_at_us != 0 ? cmd.execute_at_us : cmd.received_us);
+#else
             rapidMove(cmd.rapid_move.x, cmd.rapid_move.y, cmd.rapid_move.z);
+#endif
             break;
         }
 
@@ -600,18 +1229,145 @@ void Leg::processCommandQueue()
     }
 }
 
+/**
+ * @brief Print encoder I/O counters for every axis
+ *
+ * Latency is the bus time of one transfer including any mux switch. Age is how
+ * long ago the last valid angle arrived - a large age with low failure counts
+ * means the bus is too busy to get to this encoder.
+ */
+void Leg::printEncoderDiagnostics() {
+    EncoderDiagnostics diagnostics;
+    if (!sensing.readDiagnostics(diagnostics)) {
+        Serial.println("Encoder diagnostics not available yet");
+        return;
+    }
+    uint32_t now = micros();
+    for (uint8_t i = 0; i < NUM_AXES_PER_LEG; i++) {
+        const EncoderStats& stats = diagnostics.encoders[i];
+        uint32_t mean = stats.reads ? static_cast<uint32_t>(stats.latency_sum_us / stats.reads) : 0;
+        Serial.printf("Axis %d (ch %d, period %lu us): reads %lu failures %lu magnet faults %lu retries %lu | latency us min %lu mean %lu max %lu | last good %lu us ago\n",
+            i, axes[i].getEncoderChannel(), axes[i].getSamplePeriodUs(), stats.reads, stats.failures, stats.invalid, stats.retries,
+            stats.reads ? stats.latency_min_us : 0, mean, stats.latency_max_us,
+            stats.last_good_us ? now - stats.last_good_us : 0);
+        Serial.print("  histogram:");
+        for (uint8_t b = 0; b < ENCODER_LATENCY_BUCKETS; b++) {
+            Serial.printf(" <%lu:%lu", static_cast<uint32_t>(ENCODER_LATENCY_FIRST_BUCKET_US) << b, stats.latency_histogram[b]);
+        }
+        Serial.println();
+    }
+}
+
+#if AXIS_OBSERVER_BENCH
+/**
+ * @brief Print the observer bench results for every axis
+ *
+ * Move the leg back and forth (or run a test gait) first - lag is only
+ * measured at direction reversals.
+ */
+void Leg::printObserverBench() {
+    for (uint8_t i = 0; i < NUM_AXES_PER_LEG; i++) {
+        uint32_t reversals, mean_lag_us, max_lag_us;
+        axes[i].getObserverBench(reversals, mean_lag_us, max_lag_us);
+        Serial.printf("Axis %d: %lu reversals, legacy filter lags observer by mean %lu us, max %lu us\n",
+            i, reversals, mean_lag_us, max_lag_us);
+    }
+}
+#endif
+
+#if PWM_DRIVER_BENCH
+/**
+ * @brief Time one duty update of every motor pin, library call vs. staged levels + latch
+ *
+ * Writes 0 % to all pins, so motion is disabled on every axis first.
+ */
+void Leg::benchmarkPwm() {
+    const uint8_t pins[] = {D8, D10, D11, D12, D15, D16, D17, D18}; // as linked in begin()
+    for (uint8_t i = 0; i < NUM_AXES_PER_LEG; i++) {
+        stopAxis(i);
+    }
+    pwm.benchmark(pins, sizeof(pins));
+}
+#endif
+
+#if LEG_KINEMATICS_BENCH
+/**
+ * @brief Print kinematics cycle counts for the scalar_t this build uses
+ *
+ * Reports the in-service counts gathered by rapidMove() and linearMovePerform()
+ * since boot, then times forward and inverse kinematics on a 5x5x5 grid of
+ * points within 20 mm of the current toe position, and the kinematics_math
+ * kernels on their own. The sweep only solves, it does not move the axes.
+ * Rebuild with HEX3_DOUBLE_PRECISION or KINEMATICS_FAST_MATH flipped to compare.
+ */
+void Leg::benchmarkKinematics() {
+    cycleCounterBegin();
+    CycleStats fk_sweep, ik_sweep;
+    scalar_t saved_angles[NUM_AXES_PER_LEG];
+    for (uint8_t i = 0; i < NUM_AXES_PER_LEG; i++) {
+        saved_angles[i] = _next_angles[i];
+    }
+
+    scalar_t x, y, z;
+    for (int8_t dx = -2; dx <= 2; dx++) {
+        for (int8_t dy = -2; dy <= 2; dy++) {
+            for (int8_t dz = -2; dz <= 2; dz++) {
+                uint32_t start = cycleCount();
+                _forwardKinematics(_current_angles[0], _current_angles[1], _current_angles[2], x, y, z);
+                fk_sweep.add(cycleCount() - start);
+
+                start = cycleCount();
+                _inverseKinematics(_current_cartesian[0] + dx * 10.0f, _current_cartesian[1] + dy * 10.0f, _current_cartesian[2] + dz * 10.0f);
+                ik_sweep.add(cycleCount() - start);
+            }
+        }
+    }
+
+    for (uint8_t i = 0; i < NUM_AXES_PER_LEG; i++) {
+        _next_angles[i] = saved_angles[i];
+    }
+
+    // Kernels on their own, spread over the joint range. The volatile sink keeps the calls.
+    CycleStats sin_cycles, atan2_cycles, sqrt_cycles;
+    volatile scalar_t sink;
+    for (uint8_t i = 0; i < 64; i++) {
+        scalar_t angle = (i - 32) * 0.1f;
+        uint32_t start = cycleCount();
+        sink = kinSin(angle);
+        sin_cycles.add(cycleCount() - start);
+        start = cycleCount();
+        sink = kinAtan2(angle, 1.5f - i * 0.05f);
+        atan2_cycles.add(cycleCount() - start);
+        start = cycleCount();
+        sink = kinSqrt(i * 37.0f);
+        sqrt_cycles.add(cycleCount() - start);
+    }
+    (void)sink;
+
+    Serial.printf("Kinematics cycles (%s, %s)\n", HEX3_DOUBLE_PRECISION ? "double" : "float", KINEMATICS_FAST_MATH ? "fast math" : "libm");
+    Serial.printf("  rapidMove IK:       n %lu min %lu mean %lu max %lu\n",
+        _ik_cycles.count, _ik_cycles.count ? _ik_cycles.min : 0, _ik_cycles.mean(), _ik_cycles.max);
+    Serial.printf("  linearMovePerform:  n %lu min %lu mean %lu max %lu\n",
+        _linear_move_cycles.count, _linear_move_cycles.count ? _linear_move_cycles.min : 0, _linear_move_cycles.mean(), _linear_move_cycles.max);
+    Serial.printf("  sweep FK:           n %lu min %lu mean %lu max %lu\n", fk_sweep.count, fk_sweep.min, fk_sweep.mean(), fk_sweep.max);
+    Serial.printf("  sweep IK:           n %lu min %lu mean %lu max %lu\n", ik_sweep.count, ik_sweep.min, ik_sweep.mean(), ik_sweep.max);
+    Serial.printf("  kinSin:             min %lu mean %lu max %lu\n", sin_cycles.min, sin_cycles.mean(), sin_cycles.max);
+    Serial.printf("  kinAtan2:           min %lu mean %lu max %lu\n", atan2_cycles.min, atan2_cycles.mean(), atan2_cycles.max);
+    Serial.printf("  kinSqrt:            min %lu mean %lu max %lu\n", sqrt_cycles.min, sqrt_cycles.mean(), sqrt_cycles.max);
+}
+#endif
+
 float Leg::readToe() {
     return _toe_value;
 }
 
 void Leg::_updateToe() {
-    // toe.update();
     // if (millis() - _last_toe_update_time < TOE_UPDATE_INTERVAL_MS) {
     //     return;
     // }
     // _last_toe_update_time = millis();
     
-    // float toe_value = toe.read();
+    // float toe_value = _sensors.toe;
     // //toe.isPressed();
     // float compression_distance = toe.toe_idle - toe_value;
     // if (fabs(compression_distance - _last_compression_distance) > 1.0f) {
@@ -619,5 +1375,5 @@ void Leg::_updateToe() {
     // }
     // _length2_dynamic = _length2 + toe.exposed_length - _last_compression_distance;
     // _toe_value = toe_value;
-    _toe_value = 0.0;
+    _toe_value = _sensors.toe;
 }
\ No newline at end of file
@@ -10,10 +10,20 @@
 #include "axis.hpp"
 #include "config.hpp"
 #include "three_by_matrices.hpp"
+#include "i2c_bus.hpp"
 #include "mux.hpp"
+#include "pwm_driver.hpp"
 #include "voltage_monitor.hpp"
 #include "command_queue.hpp"
 #include "toe.hpp"
+#include "sensing.hpp"
+#include "scheduler.hpp"
+#include "scalar.hpp"
+#include "cycle_counter.hpp"
+#include "telemetry_frame.hpp"
+#include "telemetry_ring.hpp"
+#include "flight_recorder.hpp"
+#include "trajectory.hpp"
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -23,12 +33,44 @@
 #define HEXA_LEG
 	#define NUM_LEGS 6                             ///< Total number of legs in the hexapod
 	#define NUM_AXES_PER_LEG 3                     ///< Number of joints per leg
-	#define LINEAR_MOVE_INTERVAL_MS 6              ///< Update interval for linear movement (ms)
+	#define LEG_CONTROL_INTERVAL_US 1000           ///< Control (PID + PWM) period (us)
+	#ifndef LEG_KINEMATICS_BENCH
+		#define LEG_KINEMATICS_BENCH false           ///< count cycles spent in inverse kinematics and linearMovePerform
+	#endif
+	#ifndef LEG_CONTROL_ISR
+		#define LEG_CONTROL_ISR false                ///< run control from a hardware alarm interrupt instead of a scheduler task
+	#endif
+	#define LINEAR_MOVE_INTERVAL_MS 6              ///< Trajectory task period with LEG_CONTROL_ISR (ms), otherwise setpoints follow the control rate
 	#define LEG_POSITION_TRACK_INTERVAL_MS 6       ///< Position tracking update interval (ms)
-	#define LEG_VELOCITY_TRACK_INTERVAL_MS 30      ///< Velocity/acceleration tracking interval (ms)
-	#define MAX_LINEAR_ACCELERATION 500.0          ///< Maximum linear acceleration (mm/s^2)
+	#define LEG_JACOBIAN_MIN_SIN_ELBOW 0.02f       ///< |sin(theta2)| below this the leg is treated as singular (straight)
+	#define LEG_JACOBIAN_MIN_REACH 5.0f            ///< mm, toe this close to the yaw axis is singular too
+	#if TELEMETRY_LOGGING_SPACE == TELEMETRY_LOGGING_SPACE_BINARY
+		#define LEG_TELEMETRY_INTERVAL_MS 2        ///< Serial binary telemetry interval (ms), ~46 kB/s of frames
+	#else
+		#define LEG_TELEMETRY_INTERVAL_MS 10       ///< Serial JSON telemetry interval (ms)
+	#endif
+	#ifndef MAX_LINEAR_ACCELERATION
+		#define MAX_LINEAR_ACCELERATION 500.0f       ///< Maximum linear acceleration (mm/s^2)
+	#endif
+	#ifndef MAX_LINEAR_JERK
+		#define MAX_LINEAR_JERK 20000.0f             ///< Maximum linear jerk (mm/s^3), full acceleration after 25 ms
+	#endif
+	#ifndef LINEAR_BLEND_TOLERANCE
+		#define LINEAR_BLEND_TOLERANCE 2.0f          ///< How far (mm) a queued linear move may cut the corner into the next, 0 stops at every corner
+	#endif
 	#define TOE_UPDATE_INTERVAL_MS 30                ///< Minimum interval between toe sensor updates (ms)
 
+	/// Control interrupt timing since the last readControlTiming(), all in microseconds
+	struct ControlTiming {
+		uint32_t cycles = 0;
+		uint32_t overruns = 0;                 ///< cycles skipped because the previous one ran past the next alarm
+		uint32_t period_min_us = UINT32_MAX;   ///< time between successive handler entries
+		uint32_t period_max_us = 0;
+		uint32_t late_max_us = 0;              ///< handler entry after the alarm target
+		uint64_t late_sum_us = 0;
+		uint32_t exec_max_us = 0;
+	};
+
 	class Can;
 	enum move_stage {ACCELERATING, CRUISING, DECELERATING, STOPPED, UNINITIALIZED};
 
@@ -44,31 +86,73 @@
 			Leg();
 			Can* can;
 			void initializeAxes(uint8_t leg_number);
-			double current_angles[NUM_AXES_PER_LEG];
-			_Bool rapidMove(double x, double y, double z);
+			scalar_t current_angles[NUM_AXES_PER_LEG];
+			_Bool rapidMove(scalar_t x, scalar_t y, scalar_t z);
 			Axis axes[NUM_AXES_PER_LEG];
-			_Bool linearMoveSetup(double x, double y, double z, double target_speed, _Bool relative = false);
+			_Bool linearMoveSetup(scalar_t x, scalar_t y, scalar_t z, scalar_t target_speed, _Bool relative = false);
 			uint8_t linearMovePerform();
+			_Bool quadraticMoveSetup(const scalar_t control[NUM_AXES_PER_LEG], const scalar_t end[NUM_AXES_PER_LEG],
+			                         uint32_t duration_ms, uint32_t start_us, _Bool through = false);
 			void begin();
+			I2CBus i2c_bus;
 			Mux mux;
+			/// Motor PWM of all axes, levels latched together once per control step
+			PwmDriver pwm;
 			CommandQueue command_queue;
-			/// Main control loop - runs PID, logs telemetry, updates kinematics
+			/// Setpoint hold plus control step (control step only without LEG_CONTROL_ISR)
 			void runSpeed();
-			void setAxisTargetPos(uint8_t axis_number, double pos);
+			/// Start the control task or interrupt - call once gains are set
+			void startControl();
+			bool readControlTiming(ControlTiming& timing);
+			/// Print control interrupt period jitter
+			void printControlTiming();
+			/// Print trajectory tracking error and lag per axis, then reset it
+			void printTrackingError();
+			/// Periodic tasks of this core - call scheduler.run() from loop()
+			Scheduler scheduler;
+			/// Send queued binary telemetry and any USB flight recorder dump without blocking - call from loop()
+			void drainTelemetry();
+#if FLIGHT_RECORDER
+			/// Every control cycle, frozen around a trigger
+			FlightRecorder recorder;
+			/// Serial 'r': trigger while recording, re-arm once frozen
+			void triggerOrArmRecorder();
+#endif
+#if TELEMETRY_LOGGING_SPACE == TELEMETRY_LOGGING_SPACE_BINARY
+			/// Binary telemetry records waiting for the serial port
+			TelemetryRing telemetry;
+#endif
+			void setAxisTargetPos(uint8_t axis_number, scalar_t pos);
 			void stopAxis(uint8_t axis_number);
-			void setAxisControlConstants(uint8_t axis_number, double Kp_pos, double Kd_pos, double Kp_vel, double Ki_vel, double Kv_ff);
+			void setAxisControlConstants(uint8_t axis_number, float Kp_pos, float Kd_pos, float Kp_vel, float Ki_vel, float Kv_ff);
 			_Bool rapidMove(ThreeByOne target_pos);
 			VoltageSensor voltage_sensor = VoltageSensor();
 			void processCommandQueue();
 			Toe toe;
 			float readToe();
+			/// Sensor acquisition task - run sensing.update() from loop1() on core1
+			Sensing sensing;
+			/// Dump per-axis encoder I/O counters and latency histograms to serial
+			void printEncoderDiagnostics();
+#if AXIS_OBSERVER_BENCH
+			/// Report how far the legacy velocity filter lags the tracking observer
+			void printObserverBench();
+#endif
+#if PWM_DRIVER_BENCH
+			/// Cycle counts of a full leg PWM update, RP2040_PWM vs. PwmDriver - leg must be idle
+			void benchmarkPwm();
+#endif
+#if LEG_KINEMATICS_BENCH
+			/// Print kinematics cycle counts (in service, an FK/IK sweep and the math kernels)
+			void benchmarkKinematics();
+#endif
 		private:
 			// Physical properties and calibration
 			uint8_t _leg_number;                         ///< Identifier for this leg (0-5)
-			double _length0 = 112.929;                   ///< Length of base link (mm)
-			double _length1 = 96.00;                     ///< Length of first joint link (mm)
-			double _length2 = 196.55; 		   			 ///< Length of second joint link (mm) 
-			double _length2_dynamic = _length2;             ///< Length of second joint link (mm) with adjustement for toe compression
+			scalar_t _length0 = 112.929f;                   ///< Length of base link (mm)
+			scalar_t _length1 = 96.00f;                     ///< Length of first joint link (mm)
+			scalar_t _length2 = 196.55f; 		   			 ///< Length of second joint link (mm) 
+			scalar_t _length2_dynamic = _length2;             ///< Length of second joint link (mm) with adjustement for toe compression
 
 			float _last_compression_distance = 0.0f; ///< Last measured compression distance of the toe sensor (mm)
 			uint32_t _last_toe_update_time = 0;      ///< Timestamp of last toe update
@@ -80,50 +164,100 @@
 			void _moveAxes();
 			
 			/// Validate that Cartesian coordinates are safe for the leg
-			_Bool _checkSafeCoords(double x, double y, double z);
+			_Bool _checkSafeCoords(scalar_t x, scalar_t y, scalar_t z);
 			
 			/// Calculate joint angles from Cartesian position
-			_Bool _inverseKinematics(double x, double y, double z);
+			_Bool _inverseKinematics(scalar_t x, scalar_t y, scalar_t z);
 			
 			/// Calculate Cartesian position from joint angles
-			_Bool _forwardKinematics(double theta0, double theta1, double theta2, double& x, double& y, double& z);
+			_Bool _forwardKinematics(scalar_t theta0, scalar_t theta1, scalar_t theta2, scalar_t& x, scalar_t& y, scalar_t& z);
 			
-			/// Update position and velocity tracking from current axis positions
+			/// Update joint tracking from the latest sensor snapshot
 			void _trackMotion();
+			/// Read-compute-write: tracking, PID, PWM for all axes
+			void _controlStep();
+			/// A linear move is accelerating, cruising or decelerating, or a curve segment is running
+			_Bool _moveActive();
+			/// Start a queued linear move early so it blends into the running one, false if it is not time yet
+			_Bool _blendLinearMove(const Command& cmd, uint32_t now_us);
+			/// Advance the curve segment to now and solve IK for it, false if none is running
+			_Bool _quadraticMovePerform();
+#if RAPID_INTERPOLATION
+			/// Advance along the RAPID setpoint spline and solve IK for it, false if it is not running
+			_Bool _rapidSplinePerform();
+#endif
+			/// Solve IK for a trajectory sample and set its feedforward, false (feedforward cleared) if unreachable
+			_Bool _followTrajectoryPoint(const TrajectoryPoint& point);
+			/// Joint feedforward from a Cartesian velocity and acceleration at the _next_angles setpoint
+			void _setCartesianFeedforward(ThreeByOne velocity, ThreeByOne acceleration, scalar_t step_s);
+#if LEG_CONTROL_ISR
+			static Leg* _control_leg;                    ///< instance served by the alarm handler
+			static void _controlAlarm(uint alarm_num);
+			uint _control_alarm = 0;
+			uint64_t _control_target_us = 0;             ///< absolute time of the pending alarm
+			uint64_t _control_last_entry_us = 0;
+			ControlTiming _control_timing;
+#endif
+			/// Forward kinematics and Jacobian mapping of the current joint state
+			void _updateKinematics();
+
+			/// Toe velocity per joint rate, command frame (columns are d(x, y, z)/d theta_j)
+			void _jacobian(const scalar_t angles[NUM_AXES_PER_LEG], ThreeByThree& jacobian);
+			/// Closed-form inverse of _jacobian(), false near a singularity
+			_Bool _jacobianInverse(const scalar_t angles[NUM_AXES_PER_LEG], ThreeByThree& inverse);
+			/// Jacobian derivative times joint rates: toe acceleration with zero joint acceleration
+			ThreeByOne _jacobianRateTerm(const scalar_t angles[NUM_AXES_PER_LEG], const scalar_t rates[NUM_AXES_PER_LEG]);
+			/// Serial JSON or binary telemetry
+			void _logTelemetry();
+			uint16_t _telemetry_sequence = 0;            ///< sequence number of the next binary telemetry record
+			/// Register control, trajectory and tracking tasks with the scheduler
+			void _registerTasks();
+#if FLIGHT_RECORDER
+			void _recordFlightSample();
+#endif
+#if LEG_KINEMATICS_BENCH
+			CycleStats _ik_cycles;                       ///< in-service inverse kinematics (rapidMove)
+			CycleStats _linear_move_cycles;              ///< active linearMovePerform() steps
+#endif
+
+			SensorSnapshot _sensors;                     ///< Latest snapshot published by the sensing core
 
-			// Motion tracking variables
-			uint32_t _last_pos_update_time = 0;          ///< Timestamp of last position update
-			uint32_t _last_velocity_update_time = 0;     ///< Timestamp of last velocity update
-			
 			// Joint angle tracking (radians)
-			double _next_angles[NUM_AXES_PER_LEG];       ///< Target angles for next move
-			double _current_angles[NUM_AXES_PER_LEG];    ///< Current measured angles
-			double _next_velocities[NUM_AXES_PER_LEG];   ///< Target velocities
-			double _current_velocities[NUM_AXES_PER_LEG];///< Current measured velocities (rad/s)
-			uint32_t _last_linear_move_time = 0;         ///< Timestamp of last linear move update
+			scalar_t _next_angles[NUM_AXES_PER_LEG];       ///< Target angles for next move
+			scalar_t _current_angles[NUM_AXES_PER_LEG];    ///< Current measured angles
+			scalar_t _next_velocities[NUM_AXES_PER_LEG];   ///< Joint feedforward velocities (rad/s)
+			scalar_t _next_accelerations[NUM_AXES_PER_LEG];///< Joint feedforward accelerations (rad/s^2)
+			scalar_t _current_velocities[NUM_AXES_PER_LEG];///< Current measured velocities (rad/s)
 			
 			// Cartesian position tracking
-			double _current_cartesian[NUM_AXES_PER_LEG]; ///< Current XYZ position (mm)
+			scalar_t _current_cartesian[NUM_AXES_PER_LEG]; ///< Current XYZ position (mm)
 			
 			// Position derivatives for motion analysis
-			double _current_pos[NUM_AXES_PER_LEG];       ///< Cartesian position (mm)
-			double _current_velocity[NUM_AXES_PER_LEG];  ///< Cartesian velocity (mm/s)
-			double _current_acceleration[NUM_AXES_PER_LEG]; ///< Cartesian acceleration (mm/s^2)
-			double _last_pos[NUM_AXES_PER_LEG];          ///< Previous position for derivative
-			double _last_velocity[NUM_AXES_PER_LEG];     ///< Previous velocity for derivative
+			scalar_t _current_pos[NUM_AXES_PER_LEG];       ///< Cartesian position (mm)
+			scalar_t _current_velocity[NUM_AXES_PER_LEG];  ///< Cartesian velocity (mm/s)
+			scalar_t _current_acceleration[NUM_AXES_PER_LEG]; ///< Cartesian acceleration (mm/s^2)
 			
 			// Linear movement variables (for velocity-profiled moves)
-			double _next_cartesian[NUM_AXES_PER_LEG];    ///< Next setpoint during linear move
-			double _start_cartesian[NUM_AXES_PER_LEG];   ///< Starting position of move
-			double _end_cartesian[NUM_AXES_PER_LEG];     ///< Target position of move
-			uint32_t _move_start_time;                   ///< Timestamp when move started
-			double _max_speed = 1000000.0;               ///< Maximum allowable speed (mm/s)
-			uint32_t _move_time;                         ///< Total time for move (ms)
+			scalar_t _next_cartesian[NUM_AXES_PER_LEG];    ///< Next setpoint during linear move
+			scalar_t _start_cartesian[NUM_AXES_PER_LEG];   ///< Starting position of move
+			scalar_t _end_cartesian[NUM_AXES_PER_LEG];     ///< Target position of move
+			uint32_t _move_start_us;                     ///< micros() when the move started
+			scalar_t _max_speed = 1000000.0;               ///< Maximum allowable speed (mm/s)
 			_Bool _moving_flag = false;                  ///< Whether a move is in progress
-			double _target_speed;                        ///< Current target speed (mm/s)
-			double _last_speed;                          ///< Previous speed for smoothing
-			uint32_t _accel_time;                        ///< Acceleration time (ms)
+			SCurveProfile _linear_profile;               ///< Distance along the move against time
 			ThreeByOne _direction_vector;                ///< Unit vector direction of motion
+
+			// Next linear move, started before the current one ends and added on top of it
+			_Bool _blend_active = false;                 ///< Whether the next move has started
+			SCurveProfile _blend_profile;
+			ThreeByOne _blend_direction;
+			scalar_t _blend_end[NUM_AXES_PER_LEG];         ///< Target of the next move (mm)
+			uint32_t _blend_start_us;                    ///< micros() when the next move started
+			_Bool _command_held = false;                 ///< The timed command at the head of the queue is due but waiting for a move
+			QuadraticSegment _curve;                     ///< CMD_QUADRATIC_MOVE segment, sampled every control step
+#if RAPID_INTERPOLATION
+			SetpointSpline _rapid_spline;                ///< received RAPID setpoints, sampled every control step
+#endif
 			
 			/// Current stage of multi-phase movement
 			move_stage _move_stage = move_stage::UNINITIALIZED;
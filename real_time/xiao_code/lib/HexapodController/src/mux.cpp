@@ -1,73 +1,181 @@
 #include <Arduino.h>
 #include <stdint.h>
-#include <Wire.h>
+#include "i2c_bus.hpp"
 #include "mux.hpp"
+#include "user_config.hpp"
+#include "log_levels.hpp"
 
 Mux::Mux() {}
 
-void Mux::begin(){
-    Wire.setClock(400000); // Set I2C clock to 400kHz
+/**
+ * @brief Wait for the multiplexer to answer and prepare one read request per channel
+ *
+ * Blocking; call from setup() after I2CBus::begin().
+ */
+void Mux::begin(I2CBus& bus){
+    _bus = &bus;
     if (_initialized) {
         return;
     }
-    Wire.begin();
     while (!_initialized){
-        Wire.beginTransmission(MUX_ADDR);
-        if (Wire.endTransmission() == 0) {
+        if (_bus->probe(MUX_ADDR)) {
             _initialized = true;
         }
-        delay(2);   
+        delay(2);
+    }
+    for (uint8_t channel = 0; channel < MUX_NUM_CHANNELS; channel++) {
+        I2CRequest& request = _requests[channel];
+        request.address = ENC_ADDR;
+        request.channel = channel;
+        request.priority = I2CPriority::CRITICAL;
+        // STATUS then RAW ANGLE in one transfer; the pointer starts below the
+        // angle registers, so it auto-increments through them as usual
+        request.tx[0] = ENC_STATUS_REG;
+        request.tx_len = 1;
+        request.rx_len = 3;
     }
 }
 
-void Mux::setChannel(uint8_t channel) {
-    if (channel > 7) {
-        return;
+/**
+ * @brief Queue an encoder read on a channel
+ *
+ * @param release_us Earliest micros() at which the read may start
+ * @param deadline_us micros() by which the read should have started, used to order encoder reads
+ * @return true if the read was queued, false if the channel is invalid, already pending, or the mux is not started
+ */
+bool Mux::requestEncoder(uint8_t channel, uint32_t release_us, uint32_t deadline_us) {
+    if (channel >= MUX_NUM_CHANNELS || _bus == nullptr) {
+        return false;
     }
-    if (channel  == _last_channel) {
-        return;
+    I2CRequest& request = _requests[channel];
+    if (_bus->isPending(request)) {
+        return false;
     }
-    Wire.beginTransmission(MUX_ADDR);
-    /*
-    Wire.write(0x00);
-    uint8_t err = Wire.endTransmission();
-    if (err != 0) {
-        //failed mux reset 
-        return;
-    }   
-    delay(1); //TODO
-    Wire.beginTransmission(MUX_ADDR);
-    */
-    Wire.write(1 << channel);
-    uint8_t err = Wire.endTransmission();
-    if (err != 0) {
-        //failed mux channel set
-        return;
+    request.release_us = release_us;
+    request.deadline_us = deadline_us;
+    if (!_bus->submit(request)) {
+        return false;
+    }
+    _awaiting[channel] = true;
+    _retries_left[channel] = MUX_ENCODER_MAX_RETRIES;
+    return true;
+}
+
+/**
+ * @brief Move an encoder read that has not started yet to a new slot
+ *
+ * @return false if no read is waiting on this channel
+ */
+bool Mux::rescheduleEncoder(uint8_t channel, uint32_t release_us, uint32_t deadline_us) {
+    if (channel >= MUX_NUM_CHANNELS || _bus == nullptr) {
+        return false;
     }
-    delay(1); //TODO nonblocking??
+    return _bus->reschedule(_requests[channel], release_us, deadline_us);
 }
 
-double Mux::readEncoder(uint8_t channel) {
-    // static uint32_t last_read_time = 0;
-    setChannel(channel);
-    delayMicroseconds(500);
-    Wire.beginTransmission(ENC_ADDR);
-    Wire.write(0x0E); 
-    Wire.endTransmission();
-    Wire.requestFrom(ENC_ADDR, 2);
-    if (Wire.available() == 2) {
-        // Serial.printf("Time since last read: %dus\n", micros() - last_read_time);
-        // last_read_time = micros();
-        uint8_t highByte = Wire.read();
-        uint8_t lowByte  = Wire.read();
-        uint16_t rawAngle = ((highByte & 0x0F) << 8) | lowByte; 
-        if (rawAngle > 4096) {
-            // Serial.printf("Invalid raw angle read: %d\n", rawAngle);
-            return NAN;
+bool Mux::isPending(uint8_t channel) {
+    if (channel >= MUX_NUM_CHANNELS || _bus == nullptr) {
+        return false;
+    }
+    return _bus->isPending(_requests[channel]);
+}
+
+/**
+ * @brief Decode any reads the bus has finished since the last call
+ *
+ * A failed transfer is re-queued straight away, keeping its deadline, up to
+ * MUX_ENCODER_MAX_RETRIES times before a NAN sample is published.
+ */
+void Mux::poll() {
+    for (uint8_t channel = 0; channel < MUX_NUM_CHANNELS; channel++) {
+        I2CRequest& request = _requests[channel];
+        if (!_awaiting[channel] || _bus->isPending(request)) {
+            continue;
+        }
+        _recordTransfer(channel, request);
+
+        if (request.status == I2CStatus::FAILED && _retries_left[channel] > 0) {
+            _retries_left[channel]--;
+            request.release_us = micros();
+            if (_bus->submit(request)) {
+                _stats[channel].retries++;
+                continue;
+            }
+        }
+        _awaiting[channel] = false;
+
+        EncoderSample& sample = _samples[channel];
+        if (request.status == I2CStatus::DONE) {
+            uint8_t status = request.rx[0];
+            // without a magnet the angle is noise; too weak or too strong still reads, less accurately
+            sample.angle = (status & ENC_STATUS_MD) ? _decodeAngle(request.rx[1], request.rx[2]) : NAN;
+            if ((status & (ENC_STATUS_MD | ENC_STATUS_ML | ENC_STATUS_MH)) != ENC_STATUS_MD) {
+                _stats[channel].invalid++;
+            }
+            else {
+                _stats[channel].last_good_us = request.completed_us;
+            }
+        }
+        else {
+            #if LOG_LEVEL >= CALCULATION_DEBUG
+                Serial.printf("Failed to read encoder %d\n", channel);
+            #endif
+            sample.angle = NAN;
         }
-        double radians = (rawAngle * M_PI * 2.0) / 4096.0 - M_PI; // Map to -pi to pi
-        return radians;
+        sample.timestamp_us = request.completed_us;
+        sample.sequence++;
     }
-    Serial.printf("Failed to read encoder %d\n", channel                                            );
-    return NAN;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Copy out the I/O counters for a channel
+ *
+ * Only call from the core that runs poll(); the control core gets them through
+ * Sensing::readDiagnostics().
+ */
+bool Mux::encoderStats(uint8_t channel, EncoderStats& stats) {
+    if (channel >= MUX_NUM_CHANNELS) {
+        return false;
+    }
+    stats = _stats[channel];
+    return true;
+}
+
+void Mux::_recordTransfer(uint8_t channel, const I2CRequest& request) {
+    EncoderStats& stats = _stats[channel];
+    stats.reads++;
+    if (request.status == I2CStatus::FAILED) {
+        stats.failures++;
+    }
+    uint32_t latency = request.completed_us - request.started_us;
+    if (latency < stats.latency_min_us) {
+        stats.latency_min_us = latency;
+    }
+    if (latency > stats.latency_max_us) {
+        stats.latency_max_us = latency;
+    }
+    stats.latency_sum_us += latency;
+    uint8_t bucket = 0;
+    while (bucket < ENCODER_LATENCY_BUCKETS - 1 && latency >= (static_cast<uint32_t>(ENCODER_LATENCY_FIRST_BUCKET_US) << bucket)) {
+        bucket++;
+    }
+    stats.latency_histogram[bucket]++;
+}
+
+/**
+ * @brief Copy out the most recent completed read for a channel
+ *
+ * @return true if at least one read has completed on this channel
+ */
+bool Mux::latestEncoderSample(uint8_t channel, EncoderSample& sample) {
+    if (channel >= MUX_NUM_CHANNELS) {
+        return false;
+    }
+    sample = _samples[channel];
+    return sample.sequence != 0;
+}
+
+float Mux::_decodeAngle(uint8_t high_byte, uint8_t low_byte) {
+    uint16_t rawAngle = ((high_byte & 0x0F) << 8) | low_byte;
+    return rawAngle * (2.0f * static_cast<float>(M_PI) / 4096.0f) - static_cast<float>(M_PI); // Map to -pi to pi
+}
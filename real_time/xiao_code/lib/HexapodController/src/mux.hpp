@@ -1,23 +1,74 @@
 #include <Arduino.h>
 #include <stdint.h>
-#include <Wire.h>
+#include "i2c_bus.hpp"
 
 #ifndef HEX3_MUX
 #define HEX3_MUX
 
-    #define MUX_ADDR 0x70  
     #define ENC_ADDR 0x36
+    #define ENC_STATUS_REG 0x0B             ///< followed by RAW ANGLE (0x0C..0x0D), equal to ANGLE as ZPOS/MPOS are left unprogrammed
+    #define ENC_STATUS_MH 0x08              ///< magnet too strong
+    #define ENC_STATUS_ML 0x10              ///< magnet too weak
+    #define ENC_STATUS_MD 0x20              ///< magnet detected
 
+    #define MUX_NUM_CHANNELS 8
+    #define MUX_ENCODER_MAX_RETRIES 1          ///< immediate re-reads after a failed transfer before a NAN sample is published
+
+    #define ENCODER_LATENCY_BUCKETS 8
+    #define ENCODER_LATENCY_FIRST_BUCKET_US 64 ///< bucket i holds transfers shorter than 64us << i, the last one everything longer
+
+    /// Latest encoder reading published by the multiplexer
+    struct EncoderSample {
+        float angle = NAN;          ///< raw angle in radians [-pi, pi], NAN if the last read failed
+        uint32_t timestamp_us = 0;  ///< micros() when the read completed
+        uint32_t sequence = 0;      ///< incremented on every completed read (good or bad)
+    };
+
+    /// Per-channel I/O counters, fixed size so they can live in RAM for the whole run
+    struct EncoderStats {
+        uint32_t reads = 0;                 ///< completed transfers, including retries
+        uint32_t failures = 0;              ///< transfers that failed on the bus (NACK, timeout)
+        uint32_t invalid = 0;               ///< transfers that completed with a magnet fault: missing (angle NAN), too weak or too strong
+        uint32_t retries = 0;               ///< re-reads issued after a failure
+        uint32_t latency_min_us = UINT32_MAX; ///< transfer time, including any mux switch
+        uint32_t latency_max_us = 0;
+        uint64_t latency_sum_us = 0;
+        uint32_t latency_histogram[ENCODER_LATENCY_BUCKETS] = {0};
+        uint32_t last_good_us = 0;          ///< micros() of the last read without a magnet fault, 0 if none yet
+    };
+
+    /**
+     * @class Mux
+     * @brief AS5600 encoders behind the TCA9548A multiplexer
+     *
+     * Builds high-priority angle reads for the I2C bus scheduler, which takes care
+     * of channel selection, and decodes the results.
+     */
     class Mux {
         public:
             Mux();
-            void begin();
-            void setChannel(uint8_t channel);
-            double readEncoder(uint8_t channel);
+            void begin(I2CBus& bus);
+
+            // Non-blocking acquisition: request a channel, call poll() after the bus, pick up the result
+            bool requestEncoder(uint8_t channel, uint32_t release_us, uint32_t deadline_us);
+            bool rescheduleEncoder(uint8_t channel, uint32_t release_us, uint32_t deadline_us);
+            bool isPending(uint8_t channel);
+            void poll();
+            bool latestEncoderSample(uint8_t channel, EncoderSample& sample);
+            bool encoderStats(uint8_t channel, EncoderStats& stats);
+
         private:
             _Bool _initialized = false;
-            uint8_t _last_channel = 255;
+            I2CBus* _bus = nullptr;
+            I2CRequest _requests[MUX_NUM_CHANNELS];
+            EncoderSample _samples[MUX_NUM_CHANNELS];
+            bool _awaiting[MUX_NUM_CHANNELS] = {false};   ///< submitted and not yet decoded
+            uint8_t _retries_left[MUX_NUM_CHANNELS] = {0};
+            EncoderStats _stats[MUX_NUM_CHANNELS];
+
+            void _recordTransfer(uint8_t channel, const I2CRequest& request);
 
+            static float _decodeAngle(uint8_t high_byte, uint8_t low_byte);
     };
 
-#endif
\ No newline at end of file
+#endif
@@ -4,7 +4,7 @@
 #include <math.h>
 #include "three_by_matrices.hpp"
 
-void Position::set(double new_x, double new_y, double new_z, double new_roll, double new_pitch, double new_yaw) {
+void Position::set(scalar_t new_x, scalar_t new_y, scalar_t new_z, scalar_t new_roll, scalar_t new_pitch, scalar_t new_yaw) {
     x = new_x;
     y = new_y;
     z = new_z;
@@ -22,7 +22,7 @@ void Position::setPos(const Position& pos) {
     yaw = pos.yaw;
 }
 
-void Position::scalarMult(double factor) {
+void Position::scalarMult(scalar_t factor) {
     x = x * factor;
     y = y * factor;
     z = z * factor;
@@ -34,15 +34,15 @@ void Position::scalarMult(double factor) {
 Position Position::unitVector() {
     Position unit_vector;
     unit_vector = (*this);
-    double magnitude = unit_vector.magnitude();
-    if (fabs(magnitude) > .001) {
-        unit_vector.scalarMult(1.0 / unit_vector.magnitude());
+    scalar_t magnitude = unit_vector.magnitude();
+    if (fabs(magnitude) > .001f) {
+        unit_vector.scalarMult(1.0f / unit_vector.magnitude());
     }
 
     return unit_vector;
 }
 
-void Position::operator*=(const double& multiplier) {
+void Position::operator*=(const scalar_t& multiplier) {
     x = x * multiplier;
     y = y * multiplier;
     z = z * multiplier;
@@ -51,14 +51,14 @@ void Position::operator*=(const double& multiplier) {
     yaw = yaw * multiplier;
 }
 
-Position Position::operator*(const double& multiplier) {
+Position Position::operator*(const scalar_t& multiplier) {
     Position product;
     product.set(x, y, z, roll, pitch, yaw);
     product *= multiplier;
     return product;
 }
 
-void Position::independentScalarMult(double factors[6]) {
+void Position::independentScalarMult(scalar_t factors[6]) {
     x = x * factors[0];
     y = y * factors[1];
     z = z * factors[2];
@@ -99,31 +99,31 @@ Position Position::operator+(const Position& addend) {
     return sum;
 }
 
-double Position::magnitude() {
-    double orientation_magnitude = sqrt(roll*roll + pitch*pitch + yaw*yaw);
-    double cartesian_magnitude = sqrt(x*x + y*y + z*z);
+scalar_t Position::magnitude() {
+    scalar_t orientation_magnitude = sqrt(roll*roll + pitch*pitch + yaw*yaw);
+    scalar_t cartesian_magnitude = sqrt(x*x + y*y + z*z);
     return sqrt(orientation_magnitude*orientation_magnitude + cartesian_magnitude*cartesian_magnitude);
 }
 
-double Position::scaledMagnitude() {
-    double orientation_magnitude = sqrt(roll*roll + pitch*pitch + yaw*yaw) * ROTATION_MAGNITUDE_SCALE;
-    double cartesian_magnitude = sqrt(x*x + y*y + z*z);
+scalar_t Position::scaledMagnitude() {
+    scalar_t orientation_magnitude = sqrt(roll*roll + pitch*pitch + yaw*yaw) * ROTATION_MAGNITUDE_SCALE;
+    scalar_t cartesian_magnitude = sqrt(x*x + y*y + z*z);
     return sqrt(orientation_magnitude*orientation_magnitude + cartesian_magnitude*cartesian_magnitude);
 }
 
 
 _Bool Position::equals(const Position& pos) {
-    if (fabs(x - pos.x) > 0.003)
+    if (fabs(x - pos.x) > 0.003f)
         return false;
-    if (fabs(y - pos.y) > 0.003)
+    if (fabs(y - pos.y) > 0.003f)
         return false;
-    if (fabs(z - pos.z) > 0.003)
+    if (fabs(z - pos.z) > 0.003f)
         return false;
-    if (fabs(roll - pos.roll) > 0.003)
+    if (fabs(roll - pos.roll) > 0.003f)
         return false;
-    if (fabs(pitch - pos.pitch) > 0.003)
+    if (fabs(pitch - pos.pitch) > 0.003f)
         return false;
-    if (fabs(yaw - pos.yaw) > 0.003)
+    if (fabs(yaw - pos.yaw) > 0.003f)
         return false;
     return true;
 }
@@ -131,7 +131,7 @@ _Bool Position::equals(const Position& pos) {
 //get a position opbject from a command string
 Position getPosFromCommand(String command) {
   Position position;
-  double x = 0, y = 0, z = 0, roll = 0, pitch = 0, yaw= 0;
+  scalar_t x = 0, y = 0, z = 0, roll = 0, pitch = 0, yaw= 0;
   x = command.substring(command.indexOf('x') + 1).toFloat();
   y = command.substring(command.indexOf('y') + 1).toFloat();
   z = command.substring(command.indexOf('z') + 1).toFloat();
@@ -147,17 +147,17 @@ ThreeByOne Position::coord() {
 }
 
 _Bool Position::operator==(const Position& pos) {
-    if (fabs(x - pos.x) > 0.003)
+    if (fabs(x - pos.x) > 0.003f)
         return false;
-    if (fabs(y - pos.y) > 0.003)
+    if (fabs(y - pos.y) > 0.003f)
         return false;
-    if (fabs(z - pos.z) > 0.003)
+    if (fabs(z - pos.z) > 0.003f)
         return false;
-    if (fabs(roll - pos.roll) > 0.003)
+    if (fabs(roll - pos.roll) > 0.003f)
         return false;
-    if (fabs(pitch - pos.pitch) > 0.003)
+    if (fabs(pitch - pos.pitch) > 0.003f)
         return false;
-    if (fabs(yaw - pos.yaw) > 0.003)
+    if (fabs(yaw - pos.yaw) > 0.003f)
         return false;
     return true;
 }
@@ -167,33 +167,33 @@ _Bool Position::operator!=(const Position& pos) {
 }
 
 _Bool Position::operator<(const Position& pos) {
-    if (x - pos.x > 0.0)
+    if (x - pos.x > 0.0f)
         return false;
-    if (y - pos.y > 0.0)
+    if (y - pos.y > 0.0f)
         return false;
-    if (z - pos.z > 0.0)
+    if (z - pos.z > 0.0f)
         return false;
-    if (roll - pos.roll > 0.0)
+    if (roll - pos.roll > 0.0f)
         return false;
-    if (pitch - pos.pitch > 0.0)
+    if (pitch - pos.pitch > 0.0f)
         return false;
-    if (yaw - pos.yaw > 0.0)
+    if (yaw - pos.yaw > 0.0f)
         return false;
     return true;
 }
 
 _Bool Position::operator>(const Position& pos) {
-    if (x - pos.x < 0.0)
+    if (x - pos.x < 0.0f)
         return false;
-    if (y - pos.y < 0.0)
+    if (y - pos.y < 0.0f)
         return false;
-    if (z - pos.z < 0.0)
+    if (z - pos.z < 0.0f)
         return false;
-    if (roll - pos.roll < 0.0)
+    if (roll - pos.roll < 0.0f)
         return false;
-    if (pitch - pos.pitch < 0.0)
+    if (pitch - pos.pitch < 0.0f)
         return false;
-    if (yaw - pos.yaw < 0.0)
+    if (yaw - pos.yaw < 0.0f)
         return false;
     return true;
 }
@@ -217,12 +217,12 @@ Position Position::operator=(const Position& pos) {
 }
 
 void Position::clear() {
-    x = 0.00;
-    y = 0.00;
-    z = 0.00;
-    roll = 0.00;
-    pitch = 0.00;
-    yaw = 0.00;
+    x = 0.00f;
+    y = 0.00f;
+    z = 0.00f;
+    roll = 0.00f;
+    pitch = 0.00f;
+    yaw = 0.00f;
 }
 
 void Position::usbSerialize() {
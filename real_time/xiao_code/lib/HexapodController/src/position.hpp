@@ -9,23 +9,23 @@
 #ifndef HEXA_POSITION
 #define HEXA_POSITION
 
-	#define ROTATION_MAGNITUDE_SCALE 100.0 // Scale applied to rotations for determining scaledMagnitude() of move
+	#define ROTATION_MAGNITUDE_SCALE 100.0f // Scale applied to rotations for determining scaledMagnitude() of move
 
 	class Position {
 		public:
-			double x;
-			double y;
-			double z;
-			double roll;
-			double pitch;
-			double yaw;
+			scalar_t x;
+			scalar_t y;
+			scalar_t z;
+			scalar_t roll;
+			scalar_t pitch;
+			scalar_t yaw;
 			void setPos(const Position& pos);
-			void set(double new_x, double new_y, double new_z, double new_roll, double new_pitch, double new_yaw);
-			void scalarMult(double factor);
-			void independentScalarMult(double factors[6]);
+			void set(scalar_t new_x, scalar_t new_y, scalar_t new_z, scalar_t new_roll, scalar_t new_pitch, scalar_t new_yaw);
+			void scalarMult(scalar_t factor);
+			void independentScalarMult(scalar_t factors[6]);
 			_Bool equals(const Position& pos);
-			Position operator*(const double& multiplier);
-			void operator*=(const double& multiplier);
+			Position operator*(const scalar_t& multiplier);
+			void operator*=(const scalar_t& multiplier);
 			Position operator+(const Position& pos);
 			void  operator+=(const Position& pos);
 			Position operator-(const Position& pos);
@@ -40,8 +40,8 @@
 			ThreeByOne coord();
 			Position unitVector();
 			Position operator=(const Position& pos);
-			double magnitude();
-			double scaledMagnitude();
+			scalar_t magnitude();
+			scalar_t scaledMagnitude();
 			void usbSerialize();
 		private:
 	};
@@ -0,0 +1,97 @@
+#include "profiler.hpp"
+#include <hardware/clocks.h>
+
+#if LOOP_PROFILER
+
+static const char* const _section_names[PROFILE_NUM_SECTIONS] = {
+    "loop", "can", "linear_move", "cmd_queue", "toe", "telemetry", "ik", "pid", "tracking"
+};
+
+Profiler::Entry Profiler::_entries[PROFILE_NUM_SECTIONS];
+
+/**
+ * @brief Histogram bucket of a cycle count
+ *
+ * Counts below 2^PROFILER_SUB_BUCKET_BITS get a bucket each. Above that each
+ * power of two is split into 2^PROFILER_SUB_BUCKET_BITS equal buckets.
+ */
+uint8_t Profiler::_bucket(uint32_t cycles) {
+    if (cycles < (1UL << PROFILER_SUB_BUCKET_BITS)) {
+        return static_cast<uint8_t>(cycles);
+    }
+    uint8_t msb = 31 - __builtin_clz(cycles);
+    uint8_t shift = msb - PROFILER_SUB_BUCKET_BITS;
+    uint8_t sub = (cycles >> shift) & ((1UL << PROFILER_SUB_BUCKET_BITS) - 1);
+    return static_cast<uint8_t>(((shift + 1) << PROFILER_SUB_BUCKET_BITS) | sub);
+}
+
+/// Largest cycle count that falls into a bucket
+uint32_t Profiler::_bucketUpperBound(uint8_t bucket) {
+    if (bucket < (1UL << PROFILER_SUB_BUCKET_BITS)) {
+        return bucket;
+    }
+    uint8_t shift = (bucket >> PROFILER_SUB_BUCKET_BITS) - 1;
+    uint32_t lower = ((1UL << PROFILER_SUB_BUCKET_BITS) | (bucket & ((1UL << PROFILER_SUB_BUCKET_BITS) - 1))) << shift;
+    return lower + ((1UL << shift) - 1);
+}
+
+uint32_t Profiler::_percentile(const Entry& entry, uint32_t per_mille) {
+    if (entry.cycles.count == 0) {
+        return 0;
+    }
+    uint64_t rank = (static_cast<uint64_t>(entry.cycles.count) * per_mille + 999) / 1000;
+    uint64_t seen = 0;
+    for (uint8_t b = 0; b < PROFILER_NUM_BUCKETS; b++) {
+        seen += entry.histogram[b];
+        if (seen >= rank) {
+            uint32_t bound = _bucketUpperBound(b);
+            return bound < entry.cycles.max ? bound : entry.cycles.max;
+        }
+    }
+    return entry.cycles.max;
+}
+
+void Profiler::record(ProfileSection section, uint32_t cycles) {
+    Entry& entry = _entries[section];
+    entry.cycles.add(cycles);
+    entry.histogram[_bucket(cycles)]++;
+}
+
+void Profiler::summarize(ProfileSection section, ProfileSummary& summary) {
+    const Entry& entry = _entries[section];
+    summary.count = entry.cycles.count;
+    summary.min = entry.cycles.count ? entry.cycles.min : 0;
+    summary.mean = entry.cycles.mean();
+    summary.max = entry.cycles.max;
+    summary.p50 = _percentile(entry, 500);
+    summary.p90 = _percentile(entry, 900);
+    summary.p99 = _percentile(entry, 990);
+}
+
+const char* Profiler::sectionName(ProfileSection section) {
+    return section < PROFILE_NUM_SECTIONS ? _section_names[section] : "?";
+}
+
+/**
+ * @brief Print every section as cycles and microseconds at the current core clock
+ */
+void Profiler::print() {
+    float cycles_per_us = clock_get_hz(clk_sys) / 1e6f;
+    Serial.printf("Loop profile (cycles, %.0f per us)\n", cycles_per_us);
+    Serial.println("section       count      min     mean      p50      p90      p99      max   max_us");
+    for (uint8_t s = 0; s < PROFILE_NUM_SECTIONS; s++) {
+        ProfileSummary summary;
+        summarize(static_cast<ProfileSection>(s), summary);
+        Serial.printf("%-11s %7lu %8lu %8lu %8lu %8lu %8lu %8lu %8.1f\n",
+            _section_names[s], summary.count, summary.min, summary.mean,
+            summary.p50, summary.p90, summary.p99, summary.max, summary.max / cycles_per_us);
+    }
+}
+
+void Profiler::reset() {
+    for (uint8_t s = 0; s < PROFILE_NUM_SECTIONS; s++) {
+        _entries[s] = Entry();
+    }
+}
+
+#endif
@@ -0,0 +1,95 @@
+/**
+ * @file profiler.hpp
+ * @brief Per-section cycle profiler for the core0 loop
+ *
+ * PROFILE_SECTION(PROFILE_x) at the top of a scope times the scope with the
+ * DWT cycle counter and adds the count to that section's entry in a static
+ * table: count, min, max, sum, and a log-linear histogram (four buckets per
+ * power of two, so a percentile read from it is within 25% of the true value,
+ * rounded up and capped at the section's max).
+ *
+ * With LOOP_PROFILER false the macro expands to nothing and profiler.cpp
+ * compiles to an empty unit.
+ *
+ * Sections may nest; each counts its own scope including anything nested or
+ * any interrupt that lands inside it. With LEG_CONTROL_ISR the PID and
+ * tracking sections are recorded from the control interrupt; resetting from
+ * the loop while it runs can lose that one sample.
+ */
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "user_config.hpp"
+#include "cycle_counter.hpp"
+
+#ifndef HEX3_PROFILER
+#define HEX3_PROFILER
+
+    #ifndef LOOP_PROFILER
+        #define LOOP_PROFILER false
+    #endif
+
+    #define PROFILER_SUB_BUCKET_BITS 2
+    #define PROFILER_NUM_BUCKETS ((32 - PROFILER_SUB_BUCKET_BITS + 1) << PROFILER_SUB_BUCKET_BITS)
+
+    enum ProfileSection : uint8_t {
+        PROFILE_LOOP,               ///< one full pass of loop()
+        PROFILE_CAN,                ///< handleCAN()
+        PROFILE_LINEAR_MOVE,        ///< Leg::linearMovePerform()
+        PROFILE_COMMAND_QUEUE,      ///< Leg::processCommandQueue()
+        PROFILE_TOE,                ///< toe sample in runSpeed()
+        PROFILE_TELEMETRY,          ///< serial telemetry print
+        PROFILE_IK,                 ///< setpoint inverse kinematics in runSpeed()
+        PROFILE_PID,                ///< per-axis control and PWM latch
+        PROFILE_TRACKING,           ///< joint state from the latest encoder samples
+        PROFILE_NUM_SECTIONS
+    };
+
+    /// Condensed statistics of one section, in cycles
+    struct ProfileSummary {
+        uint32_t count = 0;
+        uint32_t min = 0;
+        uint32_t mean = 0;
+        uint32_t max = 0;
+        uint32_t p50 = 0;
+        uint32_t p90 = 0;
+        uint32_t p99 = 0;
+    };
+
+    class Profiler {
+        public:
+            static void record(ProfileSection section, uint32_t cycles);
+            static void summarize(ProfileSection section, ProfileSummary& summary);
+            static const char* sectionName(ProfileSection section);
+            static void print();
+            static void reset();
+
+        private:
+            struct Entry {
+                CycleStats cycles;
+                uint32_t histogram[PROFILER_NUM_BUCKETS];
+            };
+            static Entry _entries[PROFILE_NUM_SECTIONS];
+            static uint8_t _bucket(uint32_t cycles);
+            static uint32_t _bucketUpperBound(uint8_t bucket);
+            static uint32_t _percentile(const Entry& entry, uint32_t per_mille);
+    };
+
+    /// Times its own lifetime into one section
+    class ProfileScope {
+        public:
+            explicit ProfileScope(ProfileSection section) : _section(section), _start(cycleCount()) {}
+            ~ProfileScope() { Profiler::record(_section, cycleCount() - _start); }
+
+        private:
+            ProfileSection _section;
+            uint32_t _start;
+    };
+
+#if LOOP_PROFILER
+    #define PROFILE_SECTION(section) ProfileScope _profile_scope(section)
+#else
+    #define PROFILE_SECTION(section)
+#endif
+
+#endif
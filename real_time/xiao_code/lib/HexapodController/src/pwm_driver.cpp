@@ -0,0 +1,175 @@
+/**
+ * @file pwm_driver.cpp
+ * @brief Register-level PWM for the motor driver pins of one leg
+ */
+
+#include "pwm_driver.hpp"
+#include <hardware/clocks.h>
+#include <hardware/gpio.h>
+#include <hardware/sync.h>
+#if PWM_DRIVER_BENCH
+    #include <RP2040_PWM.h>
+    #include "cycle_counter.hpp"
+#endif
+
+PwmDriver::PwmDriver() {
+}
+
+/**
+ * @brief Hand a pin to the PWM block and return its channel handle
+ *
+ * The first pin on a slice sets the slice up for PWM_FREQUENCY with the level
+ * at 0; its partner pin only adds a handle. Call before start().
+ *
+ * @param pin GPIO number
+ * @return Channel handle for setLevel(), PWM_DRIVER_NO_CHANNEL if out of slices
+ */
+uint8_t PwmDriver::addPin(uint8_t pin) {
+    uint8_t slice_number = pwm_gpio_to_slice_num(pin);
+    uint8_t index = 0;
+    while (index < _num_slices && _slices[index].number != slice_number) {
+        index++;
+    }
+    if (index == _num_slices) {
+        if (_num_slices >= PWM_DRIVER_MAX_SLICES) {
+            return PWM_DRIVER_NO_CHANNEL;
+        }
+        _slices[index].number = slice_number;
+        _slices[index].cc = 0;
+        _num_slices++;
+        _configureSlice(slice_number);
+    }
+    if (_num_channels >= 2 * PWM_DRIVER_MAX_SLICES) {
+        return PWM_DRIVER_NO_CHANNEL;
+    }
+    gpio_set_function(pin, GPIO_FUNC_PWM);
+    _channel_slice[_num_channels] = index;
+    _channel_b[_num_channels] = pwm_gpio_to_channel(pin) == PWM_CHAN_B;
+    return _num_channels++;
+}
+
+/**
+ * @brief Divider and wrap for PWM_FREQUENCY, level 0, left stopped until start()
+ */
+void PwmDriver::_configureSlice(uint8_t slice_number) {
+    uint32_t counts = clock_get_hz(clk_sys) / PWM_FREQUENCY;
+    uint32_t divider = (counts + 0xFFFF) / 0x10000;  // smallest integer divider that fits 16 bits
+    if (divider == 0) {
+        divider = 1;
+    }
+    _clock_divider = static_cast<float>(divider);
+    _top = static_cast<uint16_t>(counts / divider - 1);
+
+    pwm_config config = pwm_get_default_config();
+    pwm_config_set_clkdiv(&config, _clock_divider);
+    pwm_config_set_wrap(&config, _top);
+    pwm_init(slice_number, &config, false);
+    pwm_set_both_levels(slice_number, 0, 0);
+}
+
+/**
+ * @brief Start all slices of this driver on the same counter value
+ *
+ * Counters are zeroed with the slices stopped, then enabled with one write to
+ * the shared enable register, so every slice wraps on the same clock edge.
+ */
+void PwmDriver::start() {
+    uint32_t mask = 0;
+    for (uint8_t i = 0; i < _num_slices; i++) {
+        pwm_set_enabled(_slices[i].number, false);
+        pwm_set_counter(_slices[i].number, 0);
+        mask |= 1u << _slices[i].number;
+    }
+    pwm_set_mask_enabled(pwm_hw->en | mask);
+}
+
+/**
+ * @brief Stage a duty cycle for a channel
+ *
+ * @param channel Handle from addPin()
+ * @param duty_cycle 0-100 %
+ */
+void PwmDriver::setLevel(uint8_t channel, float duty_cycle) {
+    if (channel >= _num_channels) {
+        return;
+    }
+    uint32_t level = static_cast<uint32_t>(duty_cycle * (_top + 1) / 100.0f);
+    if (level > static_cast<uint32_t>(_top) + 1) {
+        level = _top + 1;
+    }
+    Slice& slice = _slices[_channel_slice[channel]];
+    if (_channel_b[channel]) {
+        slice.cc = (slice.cc & 0x0000FFFF) | (level << 16);
+    }
+    else {
+        slice.cc = (slice.cc & 0xFFFF0000) | level;
+    }
+}
+
+/**
+ * @brief Write all staged levels so they latch on the same wrap
+ *
+ * Waits out the last PWM_DRIVER_LATCH_GUARD counts of a period (well under a
+ * microsecond) so the writes cannot straddle a wrap, then stores each slice's
+ * compare register with interrupts off.
+ */
+void PwmDriver::latch() {
+    if (_num_slices == 0) {
+        return;
+    }
+    uint32_t state = save_and_disable_interrupts();
+    uint8_t reference = _slices[0].number;
+    while (pwm_get_counter(reference) > _top - PWM_DRIVER_LATCH_GUARD) {
+        // let the wrap pass
+    }
+    for (uint8_t i = 0; i < _num_slices; i++) {
+        pwm_hw->slice[_slices[i].number].cc = _slices[i].cc;
+    }
+    restore_interrupts(state);
+}
+
+uint16_t PwmDriver::getTop() {
+    return _top;
+}
+
+#if PWM_DRIVER_BENCH
+/**
+ * @brief Compare one duty update through RP2040_PWM with one through this driver
+ *
+ * Both paths write 0 % to every pin, so run it with the leg idle. The library
+ * rewrites the slice setup, so the slices are configured and restarted again
+ * afterwards.
+ */
+void PwmDriver::benchmark(const uint8_t* pins, uint8_t num_pins) {
+    const uint16_t updates = 100;
+    cycleCounterBegin();
+    CycleStats library_cycles, driver_cycles;
+
+    RP2040_PWM library(pins[0], PWM_FREQUENCY, 0);
+    for (uint16_t n = 0; n < updates; n++) {
+        uint32_t start = cycleCount();
+        for (uint8_t i = 0; i < num_pins; i++) {
+            library.setPWM(pins[i], PWM_FREQUENCY, 0.0f);
+        }
+        library_cycles.add(cycleCount() - start);
+    }
+
+    for (uint8_t i = 0; i < _num_slices; i++) {
+        _configureSlice(_slices[i].number);
+    }
+    start();
+
+    for (uint16_t n = 0; n < updates; n++) {
+        uint32_t start_cycles = cycleCount();
+        for (uint8_t i = 0; i < _num_channels; i++) {
+            setLevel(i, 0.0f);
+        }
+        latch();
+        driver_cycles.add(cycleCount() - start_cycles);
+    }
+
+    Serial.printf("PWM update, %u pins: RP2040_PWM::setPWM cycles min %lu mean %lu max %lu | setLevel+latch (%u channels) min %lu mean %lu max %lu\n",
+        num_pins, library_cycles.min, library_cycles.mean(), library_cycles.max,
+        _num_channels, driver_cycles.min, driver_cycles.mean(), driver_cycles.max);
+}
+#endif
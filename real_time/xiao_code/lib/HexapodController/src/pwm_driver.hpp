@@ -0,0 +1,67 @@
+/**
+ * @file pwm_driver.hpp
+ * @brief Register-level PWM for the motor driver pins of one leg
+ *
+ * RP2040_PWM::setPWM() recomputes divider and wrap and rewrites the slice on
+ * every call, and each pin it touches changes at its own moment. Here a slice
+ * is configured once when its first pin is added; after that a duty change is
+ * only a compare level.
+ *
+ * Levels are staged with setLevel() and written by latch(). The compare
+ * registers are double buffered in hardware and take effect when the counter
+ * wraps. start() restarts all slices from zero in one register write, so they
+ * wrap together. latch() writes every slice's compare register back to back,
+ * away from the wrap, so all channels of the leg change on the same period
+ * boundary.
+ */
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <hardware/pwm.h>
+#include "user_config.hpp"
+
+#ifndef HEX3_PWM_DRIVER
+#define HEX3_PWM_DRIVER
+
+    #define PWM_FREQUENCY 50000 // Hz
+    #define PWM_DRIVER_MAX_SLICES 8             ///< one per motor pin of a leg in the worst case (4-pin axis + two 2-pin axes)
+    #define PWM_DRIVER_LATCH_GUARD 64           ///< counts before the wrap in which latch() waits for the next period
+    #define PWM_DRIVER_NO_CHANNEL 255
+    #ifndef PWM_DRIVER_BENCH
+        #define PWM_DRIVER_BENCH false
+    #endif
+
+    class PwmDriver {
+        public:
+            PwmDriver();
+            /// Route a pin to its PWM slice, configuring the slice on first use. Returns a channel handle
+            uint8_t addPin(uint8_t pin);
+            /// Restart every configured slice from zero so they wrap together
+            void start();
+            /// Stage a duty cycle in percent, written by the next latch()
+            void setLevel(uint8_t channel, float duty_cycle);
+            /// Write all staged levels; they take effect together at the next wrap
+            void latch();
+            uint16_t getTop();
+#if PWM_DRIVER_BENCH
+            /// Cycle counts of RP2040_PWM::setPWM() against setLevel() + latch() on the given pins at 0% duty
+            void benchmark(const uint8_t* pins, uint8_t num_pins);
+#endif
+
+        private:
+            struct Slice {
+                uint8_t number = 0;
+                uint32_t cc = 0;                ///< staged compare register, channel A low half, B high half
+            };
+            Slice _slices[PWM_DRIVER_MAX_SLICES];
+            uint8_t _num_slices = 0;
+            uint8_t _channel_slice[2 * PWM_DRIVER_MAX_SLICES];   ///< handle -> index into _slices
+            uint8_t _channel_b[2 * PWM_DRIVER_MAX_SLICES];       ///< handle -> channel B of the slice
+            uint8_t _num_channels = 0;
+            uint16_t _top = 0;
+            float _clock_divider = 1.0f;
+
+            void _configureSlice(uint8_t slice_number);
+    };
+
+#endif
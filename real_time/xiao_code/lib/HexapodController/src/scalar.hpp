@@ -0,0 +1,32 @@
+/**
+ * @file scalar.hpp
+ * @brief Scalar type for the kinematics, matrix and motion-planning math
+ *
+ * The RP2350's Cortex-M33 has a single-precision FPU only; every double
+ * operation is a soft-float library call. Kinematics and trajectory math use
+ * scalar_t, which is float unless HEX3_DOUBLE_PRECISION is set (e.g. to compare
+ * cycle counts or rule out precision problems).
+ *
+ * Write literals in this math with an f suffix (0.5f) so a float build stays
+ * in single precision; -Wdouble-promotion flags the ones that slip through.
+ */
+
+#include <math.h>
+#include "user_config.hpp"
+
+#ifndef HEX3_SCALAR
+#define HEX3_SCALAR
+
+    #ifndef HEX3_DOUBLE_PRECISION
+        #define HEX3_DOUBLE_PRECISION false
+    #endif
+
+    #if HEX3_DOUBLE_PRECISION
+        typedef double scalar_t;
+    #else
+        typedef float scalar_t;
+    #endif
+
+    #define SCALAR_PI static_cast<scalar_t>(M_PI)
+
+#endif
@@ -0,0 +1,143 @@
+/**
+ * @file scheduler.cpp
+ * @brief Implementation of the fixed-rate task scheduler
+ */
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <atomic>
+#include <pico/time.h>
+#include "scheduler.hpp"
+
+std::atomic<uint32_t> Scheduler::_ticks{0};
+std::atomic<uint32_t> Scheduler::_tick_us{0};
+bool Scheduler::_tick_started = false;
+repeating_timer_t Scheduler::_timer;
+
+Scheduler::Scheduler() {}
+
+/**
+ * @brief Start the shared tick if no other scheduler has yet
+ *
+ * Call from setup() on core0 before any task is added on either core. The
+ * timer interrupt runs on core0 and only bumps a counter.
+ */
+void Scheduler::begin() {
+    if (_tick_started) {
+        return;
+    }
+    _tick_started = true;
+    _tick_us.store(micros(), std::memory_order_relaxed);
+    add_repeating_timer_us(-SCHEDULER_TICK_US, _onTick, nullptr, &_timer); // negative: period measured start to start
+}
+
+bool Scheduler::_onTick(repeating_timer_t* timer) {
+    _tick_us.store(micros(), std::memory_order_relaxed);
+    _ticks.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+uint32_t Scheduler::ticks() {
+    return _ticks.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief Register a periodic task
+ *
+ * @param name Short label for the stats report (not copied)
+ * @param period_us Rounded down to whole ticks, at least one
+ * @param phase_us Offset of the first release from now, to spread tasks with the same period
+ * @param priority Lower runs first when several tasks are due
+ * @return false if the task table is full
+ */
+bool Scheduler::addTask(const char* name, TaskFunction function, void* context, uint32_t period_us, uint32_t phase_us, uint8_t priority) {
+    if (_num_tasks >= SCHEDULER_MAX_TASKS || function == nullptr) {
+        return false;
+    }
+    Task task;
+    task.name = name;
+    task.function = function;
+    task.context = context;
+    task.period_ticks = period_us >= SCHEDULER_TICK_US ? period_us / SCHEDULER_TICK_US : 1;
+    task.priority = priority;
+    task.next_release = ticks() + phase_us / SCHEDULER_TICK_US;
+
+    // insertion sort, tasks of equal priority keep registration order
+    uint8_t i = _num_tasks;
+    while (i > 0 && _tasks[i - 1].priority > priority) {
+        _tasks[i] = _tasks[i - 1];
+        i--;
+    }
+    _tasks[i] = task;
+    _num_tasks++;
+    return true;
+}
+
+/**
+ * @brief Run every task that is due, highest priority first, never waits
+ *
+ * After each task the scan starts over, so a higher priority task released
+ * while a lower one ran goes next. A task that is more than one period late
+ * runs once and counts the releases it missed as overruns.
+ */
+void Scheduler::run() {
+    uint8_t i = 0;
+    while (i < _num_tasks) {
+        Task& task = _tasks[i];
+        uint32_t now = ticks();
+        int32_t late_ticks = static_cast<int32_t>(now - task.next_release);
+        if (late_ticks < 0) {
+            i++;
+            continue;
+        }
+        uint32_t missed = late_ticks / task.period_ticks;
+        task.stats.overruns += missed;
+        task.next_release += (missed + 1) * task.period_ticks;
+
+        uint32_t start_us = micros();
+        uint32_t latency_us = (late_ticks % task.period_ticks) * SCHEDULER_TICK_US + (start_us - _tick_us.load(std::memory_order_relaxed));
+        task.function(task.context);
+        uint32_t exec_us = micros() - start_us;
+
+        TaskStats& stats = task.stats;
+        stats.runs++;
+        stats.exec_sum_us += exec_us;
+        if (exec_us < stats.exec_min_us) {
+            stats.exec_min_us = exec_us;
+        }
+        if (exec_us > stats.exec_max_us) {
+            stats.exec_max_us = exec_us;
+        }
+        if (latency_us > stats.start_latency_max_us) {
+            stats.start_latency_max_us = latency_us;
+        }
+        if (exec_us > task.period_ticks * SCHEDULER_TICK_US) {
+            stats.overruns++;
+        }
+        i = 0;
+    }
+}
+
+void Scheduler::resetStats() {
+    for (uint8_t i = 0; i < _num_tasks; i++) {
+        _tasks[i].stats = TaskStats();
+    }
+}
+
+/**
+ * @brief Print one line per task: rate, execution time, start latency and overruns
+ *
+ * May be called from the other core for a quick look; the counters are read
+ * without synchronization, so a line can be one update out of date.
+ */
+void Scheduler::printStats(const char* label) {
+    for (uint8_t i = 0; i < _num_tasks; i++) {
+        const Task& task = _tasks[i];
+        const TaskStats& stats = task.stats;
+        uint32_t mean_us = stats.runs ? static_cast<uint32_t>(stats.exec_sum_us / stats.runs) : 0;
+        Serial.printf("%s %-12s p%d %5lu us | runs %lu exec us min %lu mean %lu max %lu | start latency max %lu us | overruns %lu\n",
+            label, task.name, task.priority, task.period_ticks * SCHEDULER_TICK_US,
+            stats.runs, stats.runs ? stats.exec_min_us : 0, mean_us, stats.exec_max_us,
+            stats.start_latency_max_us, stats.overruns);
+    }
+}
@@ -0,0 +1,71 @@
+/**
+ * @file scheduler.hpp
+ * @brief Fixed-rate cooperative task scheduler on a hardware timer tick
+ *
+ * A repeating hardware timer advances a shared tick counter every
+ * SCHEDULER_TICK_US. Each core that wants periodic work owns a Scheduler,
+ * registers its tasks with a period, phase and priority, and calls run() from
+ * its loop. Task releases are counted in ticks, so they stay on a fixed grid no
+ * matter how long the loop took to get around; run() starts due tasks in
+ * priority order, times them and counts overruns.
+ *
+ * Tasks are not preempted - a long task delays everything behind it, which
+ * shows up as start latency and overruns in the stats.
+ */
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <atomic>
+#include <pico/time.h>
+
+#ifndef HEX3_SCHEDULER
+#define HEX3_SCHEDULER
+
+    #define SCHEDULER_TICK_US 500
+    #define SCHEDULER_MAX_TASKS 10
+
+    typedef void (*TaskFunction)(void* context);
+
+    /// Per-task timing, all in microseconds
+    struct TaskStats {
+        uint32_t runs = 0;
+        uint32_t overruns = 0;              ///< releases missed, plus runs that took longer than the period
+        uint32_t exec_min_us = UINT32_MAX;
+        uint32_t exec_max_us = 0;
+        uint64_t exec_sum_us = 0;
+        uint32_t start_latency_max_us = 0;  ///< worst delay from release to start
+    };
+
+    struct Task {
+        const char* name = nullptr;
+        TaskFunction function = nullptr;
+        void* context = nullptr;
+        uint32_t period_ticks = 1;
+        uint8_t priority = 0;               ///< 0 runs first
+        uint32_t next_release = 0;          ///< tick of the next release
+        TaskStats stats;
+    };
+
+    class Scheduler {
+        public:
+            Scheduler();
+            void begin();
+            bool addTask(const char* name, TaskFunction function, void* context, uint32_t period_us, uint32_t phase_us = 0, uint8_t priority = 0);
+            void run();
+            void resetStats();
+            void printStats(const char* label);
+
+            static uint32_t ticks();
+
+        private:
+            Task _tasks[SCHEDULER_MAX_TASKS];   ///< kept sorted by priority
+            uint8_t _num_tasks = 0;
+
+            static std::atomic<uint32_t> _ticks;
+            static std::atomic<uint32_t> _tick_us;  ///< micros() at the last tick
+            static bool _tick_started;
+            static repeating_timer_t _timer;
+            static bool _onTick(repeating_timer_t* timer);
+    };
+
+#endif
@@ -0,0 +1,158 @@
+/**
+ * @file sensing.cpp
+ * @brief Implementation of the core1 sensing task
+ */
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <atomic>
+#include "sensing.hpp"
+#include "axis.hpp"
+
+Sensing::Sensing() :
+    _bus(nullptr),
+    _mux(nullptr),
+    _toe(nullptr),
+    _voltage_sensor(nullptr)
+{
+    for (uint8_t i = 0; i < SENSING_NUM_ENCODERS; i++) {
+        _encoder_period_us[i].store(AXIS_SAMPLE_PERIOD_MIN_US, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Hand the sensors over to the sensing task
+ *
+ * Called from setup() on core0 once the hardware is initialized and the
+ * scheduler tick is running. loop1() idles until this has run.
+ *
+ * @param encoder_channels Multiplexer channel of each axis encoder, in axis order
+ */
+void Sensing::begin(I2CBus* bus, Mux* mux, Toe* toe, VoltageSensor* voltage_sensor, const uint8_t encoder_channels[SENSING_NUM_ENCODERS]) {
+    _bus = bus;
+    _mux = mux;
+    _toe = toe;
+    _voltage_sensor = voltage_sensor;
+    for (uint8_t i = 0; i < SENSING_NUM_ENCODERS; i++) {
+        _encoder_channels[i] = encoder_channels[i];
+        _release_us[i] = micros();
+        _booked_period_us[i] = 0;
+    }
+    scheduler.addTask("toe", [](void* sensing) { static_cast<Sensing*>(sensing)->_updateToe(); },
+        this, SENSING_TOE_INTERVAL_US, 0, 0);
+    scheduler.addTask("voltage", [](void* sensing) { static_cast<Sensing*>(sensing)->_updateVoltage(); },
+        this, VOLTAGE_FILTER_INTERVAL_MS * 1000, SCHEDULER_TICK_US, 1);
+    scheduler.addTask("diagnostics", [](void* sensing) { static_cast<Sensing*>(sensing)->_publishDiagnostics(); },
+        this, SENSING_DIAGNOSTICS_INTERVAL_MS * 1000, 2 * SCHEDULER_TICK_US, 2);
+    _started.store(true, std::memory_order_release);
+}
+
+/**
+ * @brief Set how often an encoder is read
+ *
+ * The control core passes on each axis' Axis::getSamplePeriodUs() so moving
+ * joints get more bus slots than settled ones. Takes effect for the next read,
+ * or pulls an already booked read forward if the period got shorter.
+ *
+ * @param encoder Axis index
+ * @param period_us Clamped to AXIS_SAMPLE_PERIOD_MIN_US..AXIS_SAMPLE_PERIOD_MAX_US
+ */
+void Sensing::setEncoderPeriod(uint8_t encoder, uint32_t period_us) {
+    if (encoder >= SENSING_NUM_ENCODERS) {
+        return;
+    }
+    period_us = constrain(period_us, static_cast<uint32_t>(AXIS_SAMPLE_PERIOD_MIN_US), static_cast<uint32_t>(AXIS_SAMPLE_PERIOD_MAX_US));
+    _encoder_period_us[encoder].store(period_us, std::memory_order_relaxed);
+}
+
+/**
+ * @brief One pass of the sensing task
+ *
+ * Advances the I2C bus, books the next read of each encoder one requested
+ * period after the previous one (so the bus knows when the next encoder slot is
+ * and keeps toe traffic out of it), runs the periodic tasks that are due, and
+ * publishes a new snapshot whenever something changed.
+ */
+void Sensing::update() {
+    if (!_started.load(std::memory_order_acquire)) {
+        return;
+    }
+    _bus->poll();
+    _mux->poll();
+    uint32_t now = micros();
+    for (uint8_t i = 0; i < SENSING_NUM_ENCODERS; i++) {
+        EncoderSample sample;
+        if (_mux->latestEncoderSample(_encoder_channels[i], sample) && sample.sequence != _working.encoders[i].sequence) {
+            _working.encoders[i] = sample;
+            _changed = true;
+        }
+        uint32_t period_us = _encoder_period_us[i].load(std::memory_order_relaxed);
+        if (!_mux->isPending(_encoder_channels[i])) {
+            uint32_t release_us = _release_us[i] + period_us;
+            if (static_cast<int32_t>(now - release_us) > static_cast<int32_t>(period_us)) {
+                release_us = now; // fell more than a period behind, don't try to catch up
+            }
+            if (_mux->requestEncoder(_encoder_channels[i], release_us, release_us + period_us)) {
+                _release_us[i] = release_us;
+                _booked_period_us[i] = period_us;
+            }
+        }
+        else if (period_us < _booked_period_us[i]) {
+            // axis started moving while a slow read was booked - move that read up
+            uint32_t release_us = _release_us[i] - _booked_period_us[i] + period_us;
+            if (_mux->rescheduleEncoder(_encoder_channels[i], release_us, release_us + period_us)) {
+                _release_us[i] = release_us;
+                _booked_period_us[i] = period_us;
+            }
+        }
+    }
+
+    scheduler.run();
+
+    if (_changed) {
+        _changed = false;
+        _working.timestamp_us = micros();
+        _seqlock.publish(_working);
+    }
+}
+
+void Sensing::_updateToe() {
+    if (_toe == nullptr || _toe->state == ToeState::UNINITIALIZED) {
+        return;
+    }
+    _toe->update();
+    float toe = _toe->read();
+    if (toe != _working.toe) {
+        _working.toe = toe;
+        _changed = true;
+    }
+}
+
+void Sensing::_updateVoltage() {
+    if (_voltage_sensor == nullptr) {
+        return;
+    }
+    _voltage_sensor->update();
+    float voltage = _voltage_sensor->filteredRead();
+    if (voltage != _working.voltage) {
+        _working.voltage = voltage;
+        _changed = true;
+    }
+}
+
+void Sensing::_publishDiagnostics() {
+    EncoderDiagnostics diagnostics;
+    diagnostics.timestamp_us = micros();
+    for (uint8_t i = 0; i < SENSING_NUM_ENCODERS; i++) {
+        _mux->encoderStats(_encoder_channels[i], diagnostics.encoders[i]);
+    }
+    _diagnostics.publish(diagnostics);
+}
+
+bool Sensing::read(SensorSnapshot& snapshot) const {
+    return _seqlock.read(snapshot);
+}
+
+bool Sensing::readDiagnostics(EncoderDiagnostics& diagnostics) const {
+    return _diagnostics.read(diagnostics);
+}
@@ -0,0 +1,115 @@
+/**
+ * @file sensing.hpp
+ * @brief Sensor acquisition task for the second RP2350 core
+ *
+ * Owns every slow sensor read (encoders through the multiplexer, toe range
+ * sensor, supply voltage) and the I2C bus scheduler they share, and publishes
+ * the results as one timestamped snapshot through a seqlock, so the control
+ * core can pick up a consistent set of readings in constant time without ever
+ * touching I2C or the ADC.
+ */
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <atomic>
+#include "i2c_bus.hpp"
+#include "mux.hpp"
+#include "toe.hpp"
+#include "voltage_monitor.hpp"
+#include "scheduler.hpp"
+
+#ifndef HEX3_SENSING
+#define HEX3_SENSING
+
+    #define SENSING_NUM_ENCODERS 3
+    #define SENSING_READ_RETRIES 4    ///< seqlock read attempts before giving up on a snapshot
+    #define SENSING_DIAGNOSTICS_INTERVAL_MS 50
+    #define SENSING_TOE_INTERVAL_US 1000      ///< toe state machine step; its own read/reset timing sits on top
+
+    /// Everything the control core needs from the sensors, published as one unit
+    struct SensorSnapshot {
+        uint32_t timestamp_us = 0;                        ///< micros() when this snapshot was published
+        EncoderSample encoders[SENSING_NUM_ENCODERS];     ///< latest read per axis, in axis order
+        float toe = 0.0f;                                 ///< toe range (mm), 0 if the toe sensor is not running
+        float voltage = -1.0f;                            ///< filtered supply voltage (V)
+    };
+
+    /// Encoder I/O counters for every axis, published at SENSING_DIAGNOSTICS_INTERVAL_MS
+    struct EncoderDiagnostics {
+        uint32_t timestamp_us = 0;
+        EncoderStats encoders[SENSING_NUM_ENCODERS];
+    };
+
+    /**
+     * @class Seqlock
+     * @brief Single-writer, lock-free value exchange between the two cores
+     *
+     * The writer bumps the sequence to odd, copies the value, then bumps it to
+     * even. A reader that sees an odd or changed sequence retries, at most
+     * SENSING_READ_RETRIES times so the read stays constant time.
+     */
+    template <typename T>
+    class Seqlock {
+        public:
+            void publish(const T& value) {
+                uint32_t sequence = _sequence.load(std::memory_order_relaxed);
+                _sequence.store(sequence + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+                _value = value;
+                _sequence.store(sequence + 2, std::memory_order_release);
+            }
+
+            /// @param[out] value Left untouched unless a consistent copy was obtained
+            bool read(T& value) const {
+                T copy;
+                for (uint8_t attempt = 0; attempt < SENSING_READ_RETRIES; attempt++) {
+                    uint32_t before = _sequence.load(std::memory_order_acquire);
+                    if (before == 0 || (before & 1)) {
+                        continue;
+                    }
+                    copy = _value;
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (_sequence.load(std::memory_order_relaxed) == before) {
+                        value = copy;
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+        private:
+            std::atomic<uint32_t> _sequence{0};
+            T _value;
+    };
+
+    class Sensing {
+        public:
+            Sensing();
+            void begin(I2CBus* bus, Mux* mux, Toe* toe, VoltageSensor* voltage_sensor, const uint8_t encoder_channels[SENSING_NUM_ENCODERS]);
+            void update();     ///< run from loop1(), never called from the control core
+            bool read(SensorSnapshot& snapshot) const;
+            bool readDiagnostics(EncoderDiagnostics& diagnostics) const;
+            void setEncoderPeriod(uint8_t encoder, uint32_t period_us);    ///< called from the control core
+            /// Periodic work on core1 (toe, voltage filter, diagnostics); encoders and the bus are polled every pass
+            Scheduler scheduler;
+        private:
+            std::atomic<bool> _started{false};
+            I2CBus* _bus;
+            Mux* _mux;
+            Toe* _toe;
+            VoltageSensor* _voltage_sensor;
+            uint8_t _encoder_channels[SENSING_NUM_ENCODERS];
+            std::atomic<uint32_t> _encoder_period_us[SENSING_NUM_ENCODERS];
+            uint32_t _release_us[SENSING_NUM_ENCODERS] = {0};          ///< release time of the last booked read
+            uint32_t _booked_period_us[SENSING_NUM_ENCODERS] = {0};    ///< gap between that read and the one before it
+            SensorSnapshot _working;
+            Seqlock<SensorSnapshot> _seqlock;
+            Seqlock<EncoderDiagnostics> _diagnostics;
+            bool _changed = false;                                     ///< working snapshot differs from the published one
+
+            void _updateToe();
+            void _updateVoltage();
+            void _publishDiagnostics();
+    };
+
+#endif
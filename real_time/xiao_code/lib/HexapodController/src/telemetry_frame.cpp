@@ -0,0 +1,61 @@
+#include "telemetry_frame.hpp"
+#include <string.h>
+
+uint16_t telemetryCrc16(const uint8_t* data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= static_cast<uint16_t>(data[i]) << 8;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/**
+ * @brief Consistent overhead byte stuffing
+ *
+ * Each run of up to 254 non-zero bytes is prefixed with its length + 1; a zero
+ * byte in the input ends a run and is implied by that prefix.
+ */
+size_t cobsEncode(const uint8_t* data, size_t len, uint8_t* out) {
+    size_t code_index = 0;
+    size_t write_index = 1;
+    uint8_t code = 1;
+    for (size_t i = 0; i < len; i++) {
+        if (data[i] == 0) {
+            out[code_index] = code;
+            code_index = write_index++;
+            code = 1;
+            continue;
+        }
+        out[write_index++] = data[i];
+        if (++code == 0xFF) {
+            out[code_index] = code;
+            code_index = write_index++;
+            code = 1;
+        }
+    }
+    out[code_index] = code;
+    return write_index;
+}
+
+size_t encodeFrame(const uint8_t* payload, size_t len, uint8_t* frame) {
+    if (len > FRAME_MAX_PAYLOAD) {
+        return 0;
+    }
+    uint8_t raw[FRAME_MAX_PAYLOAD + TELEMETRY_CRC_SIZE];
+    memcpy(raw, payload, len);
+    uint16_t crc = telemetryCrc16(raw, len);
+    raw[len] = crc & 0xFF;
+    raw[len + 1] = crc >> 8;
+
+    frame[0] = 0x00;
+    size_t frame_len = 1 + cobsEncode(raw, len + TELEMETRY_CRC_SIZE, &frame[1]);
+    frame[frame_len++] = 0x00;
+    return frame_len;
+}
+
+size_t telemetryEncodeFrame(const TelemetryRecord& record, uint8_t* frame) {
+    return encodeFrame(reinterpret_cast<const uint8_t*>(&record), sizeof(TelemetryRecord), frame);
+}
@@ -0,0 +1,65 @@
+/**
+ * @file telemetry_frame.hpp
+ * @brief Binary serial telemetry record and its COBS framing
+ *
+ * With TELEMETRY_LOGGING_SPACE_BINARY the telemetry task sends one fixed
+ * TelemetryRecord per interval instead of a printf'd JSON line. Encoding is a
+ * few memory copies, no float formatting.
+ *
+ * Frame on the wire:
+ *   0x00, COBS(record bytes + CRC-16/CCITT-FALSE of the record, little endian), 0x00
+ *
+ * COBS leaves no zero bytes inside the frame, so a reader resynchronises on
+ * the next 0x00 after a lost byte or after any text printed between frames;
+ * the leading delimiter keeps such text out of the next frame. The record is
+ * little endian with no padding; the host decoder (ros2_ws telemetry_tools)
+ * keeps a copy of the layout and checks version and size.
+ *
+ * Other binary serial output (the flight recorder dump) uses the same framing
+ * through encodeFrame(); the host tells the kinds apart by length and first byte.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef HEX3_TELEMETRY_FRAME
+#define HEX3_TELEMETRY_FRAME
+
+    #ifndef TELEMETRY_LOGGING_SPACE_BINARY
+        #define TELEMETRY_LOGGING_SPACE_BINARY 3
+    #endif
+
+    #define TELEMETRY_RECORD_VERSION 1
+
+    struct TelemetryRecord {
+        uint8_t version;
+        uint8_t leg;
+        uint16_t sequence;              ///< increments per record, gaps show drops
+        uint32_t timestamp_us;          ///< time_us_32() when the record was taken
+        float joint_pos[3];             ///< rad
+        float joint_vel[3];             ///< rad/s
+        float joint_acc[3];             ///< rad/s^2
+        float tracking_error[3];        ///< rad, target - position
+        float duty[3];                  ///< %
+        float cartesian_pos[3];         ///< mm, forward kinematics frame
+        float voltage;                  ///< V
+        float toe;
+    };
+    static_assert(sizeof(TelemetryRecord) == 88, "TelemetryRecord layout is shared with the host decoder");
+
+    #define TELEMETRY_CRC_SIZE 2
+    #define FRAME_MAX_PAYLOAD 256
+    /// Payload + CRC, COBS overhead of one byte per 254, both delimiters
+    #define FRAME_SIZE(payload_len) ((payload_len) + TELEMETRY_CRC_SIZE + ((payload_len) + TELEMETRY_CRC_SIZE) / 254 + 1 + 2)
+    #define TELEMETRY_FRAME_MAX_SIZE FRAME_SIZE(sizeof(TelemetryRecord))
+
+    /// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)
+    uint16_t telemetryCrc16(const uint8_t* data, size_t len);
+    /// COBS-encode len bytes into out, which needs len + len / 254 + 1 bytes. Returns the encoded length
+    size_t cobsEncode(const uint8_t* data, size_t len, uint8_t* out);
+    /// Build the complete frame for up to FRAME_MAX_PAYLOAD bytes into frame (FRAME_SIZE(len) bytes). Returns its length, 0 if too long
+    size_t encodeFrame(const uint8_t* payload, size_t len, uint8_t* frame);
+    /// Build the complete frame for a record into frame (TELEMETRY_FRAME_MAX_SIZE bytes). Returns its length
+    size_t telemetryEncodeFrame(const TelemetryRecord& record, uint8_t* frame);
+
+#endif
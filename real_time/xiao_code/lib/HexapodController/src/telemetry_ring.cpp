@@ -0,0 +1,35 @@
+#include "telemetry_ring.hpp"
+#include <string.h>
+
+static_assert((TELEMETRY_RING_SIZE & (TELEMETRY_RING_SIZE - 1)) == 0, "TELEMETRY_RING_SIZE must be a power of two");
+
+bool TelemetryRing::push(const TelemetryRecord& record) {
+    uint16_t head = _head.load(std::memory_order_relaxed);
+    if (static_cast<uint16_t>(head - _tail.load(std::memory_order_acquire)) >= TELEMETRY_RING_SIZE) {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    memcpy(&_records[head & (TELEMETRY_RING_SIZE - 1)], &record, sizeof(TelemetryRecord));
+    _head.store(static_cast<uint16_t>(head + 1), std::memory_order_release);
+    return true;
+}
+
+void TelemetryRing::drain() {
+    uint16_t tail = _tail.load(std::memory_order_relaxed);
+    while (tail != _head.load(std::memory_order_acquire)
+        && Serial.availableForWrite() >= static_cast<int>(TELEMETRY_FRAME_MAX_SIZE)) {
+        uint8_t frame[TELEMETRY_FRAME_MAX_SIZE];
+        size_t len = telemetryEncodeFrame(_records[tail & (TELEMETRY_RING_SIZE - 1)], frame);
+        tail++;
+        _tail.store(tail, std::memory_order_release); // slot is free once encoded
+        Serial.write(frame, len);
+    }
+}
+
+uint32_t TelemetryRing::getDropped() {
+    return _dropped.load(std::memory_order_relaxed);
+}
+
+uint16_t TelemetryRing::getQueued() {
+    return static_cast<uint16_t>(_head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire));
+}
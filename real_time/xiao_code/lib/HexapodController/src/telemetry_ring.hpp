@@ -0,0 +1,43 @@
+/**
+ * @file telemetry_ring.hpp
+ * @brief Lock-free queue between telemetry producers and the serial port
+ *
+ * Serial.write() on USB CDC waits for room in the TinyUSB buffer, so a host
+ * that stops reading stalls whoever writes. Producers instead push() a record
+ * into a fixed ring, which is a bounds check and one memcpy; when the ring is
+ * full the record is dropped and counted, and the sequence gap shows up in the
+ * host decoder too. drain() runs in the background from loop(), encodes
+ * queued records and writes a frame only when the CDC buffer has room for all
+ * of it, so it never blocks either.
+ *
+ * Single producer, single consumer. Either side may run on the other core or
+ * in an interrupt; the indices are atomics and each is written by one side.
+ */
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <atomic>
+#include "telemetry_frame.hpp"
+
+#ifndef HEX3_TELEMETRY_RING
+#define HEX3_TELEMETRY_RING
+
+    #define TELEMETRY_RING_SIZE 64      ///< records, power of two; 128 ms of backlog at the 2 ms binary interval
+
+    class TelemetryRing {
+        public:
+            /// Queue a record, false (and counted) if the ring is full
+            bool push(const TelemetryRecord& record);
+            /// Send queued records while the serial port has room for a whole frame
+            void drain();
+            uint32_t getDropped();
+            uint16_t getQueued();
+
+        private:
+            TelemetryRecord _records[TELEMETRY_RING_SIZE];
+            std::atomic<uint16_t> _head{0};         ///< next slot to write, producer only
+            std::atomic<uint16_t> _tail{0};         ///< next slot to read, consumer only
+            std::atomic<uint32_t> _dropped{0};
+    };
+
+#endif
@@ -4,7 +4,7 @@
 #include "three_by_matrices.hpp"
 
 void ThreeByThree::mult_left_three_by_three(const ThreeByThree& left) {
-    double temp[3][3];
+    scalar_t temp[3][3];
     for (uint8_t i = 0; i < 3; i++) {
         for (uint8_t j = 0; j < 3; j++) {
             temp[i][j] = 0;
@@ -25,7 +25,7 @@ void ThreeByThree::mult_left_three_by_three(const ThreeByThree& left) {
     }
 }
 void ThreeByThree::mult_right_three_by_three(const ThreeByThree& right) {
-    double temp[3][3];
+    scalar_t temp[3][3];
     for (uint8_t i = 0; i < 3; i++) {
         for (uint8_t j = 0; j < 3; j++) {
             temp[i][j] = 0;
@@ -47,17 +47,17 @@ void ThreeByThree::mult_right_three_by_three(const ThreeByThree& right) {
     }
 }
 
-double ThreeByThree::value(uint8_t row, uint8_t collumn) {
+scalar_t ThreeByThree::value(uint8_t row, uint8_t collumn) {
     return values[row][collumn];
 }
 
 void ThreeByThree::invert() {
-    double det = value(0,0) * (value(1, 1) * value(2, 2) - value(2, 1) * value(1, 2)) -
+    scalar_t det = value(0,0) * (value(1, 1) * value(2, 2) - value(2, 1) * value(1, 2)) -
              value(0, 1) * (value(1, 0) * value(2, 2) - value(1, 2) * value(2, 0)) +
              value(0, 2) * (value(1, 0) * value(2, 1) - value(1, 1) * value(2, 0));
 
-    double invdet = 1 / det;
-    double temp[3][3];
+    scalar_t invdet = 1 / det;
+    scalar_t temp[3][3];
     temp[0][0] = (value(1, 1) * value(2, 2) - value(2, 1) * value(1, 2)) * invdet;
     temp[0][1] = (value(0, 2) * value(2, 1) - value(0, 1) * value(2, 2)) * invdet;
     temp[0][2] = (value(0, 1) * value(1, 2) - value(0, 2) * value(1, 1)) * invdet;
@@ -76,18 +76,18 @@ void ThreeByThree::invert() {
 }
 
 ThreeByOne::ThreeByOne() {
-    values[0] = 0.0;
-    values[1] = 0.0;
-    values[2] = 0.0;
+    values[0] = 0.0f;
+    values[1] = 0.0f;
+    values[2] = 0.0f;
 }
 
-ThreeByOne::ThreeByOne(double value0, double value1, double value2) {
+ThreeByOne::ThreeByOne(scalar_t value0, scalar_t value1, scalar_t value2) {
     values[0] = value0;
     values[1] = value1;
     values[2] = value2;
 }
 
-ThreeByOne::ThreeByOne(double new_values[3]) {
+ThreeByOne::ThreeByOne(scalar_t new_values[3]) {
     values[0] = new_values[0];
     values[1] = new_values[1];
     values[2] = new_values[2];
@@ -99,17 +99,17 @@ ThreeByOne::ThreeByOne(const ThreeByOne& orig) {
     values[2] = orig.values[2];
 }
 
-double ThreeByOne::magnitude() {
+scalar_t ThreeByOne::magnitude() {
     return sqrt((values[0]*values[0]) + (values[1]*values[1]) + (values[2]*values[2]));
 }
 
-void ThreeByOne::operator*=(double multiplier) {
+void ThreeByOne::operator*=(scalar_t multiplier) {
     values[0] *= multiplier;
     values[1] *= multiplier;
     values[2] *= multiplier;
 }
 
-ThreeByOne ThreeByOne::operator*(double multiplier) {
+ThreeByOne ThreeByOne::operator*(scalar_t multiplier) {
     ThreeByOne ret_matrix = ThreeByOne(values);
     ret_matrix *= multiplier;
     return ret_matrix;
@@ -117,7 +117,7 @@ ThreeByOne ThreeByOne::operator*(double multiplier) {
 
 
 void ThreeByOne::mult_three_by_three(const ThreeByThree& left) {
-    double temp[3];
+    scalar_t temp[3];
     for (uint8_t i = 0; i < 3; i++) {
         temp[i] = 0;
     }
@@ -133,7 +133,7 @@ void ThreeByOne::mult_three_by_three(const ThreeByThree& left) {
     }
 }
 
-void ThreeByOne::rotateYaw(double yaw) {
+void ThreeByOne::rotateYaw(scalar_t yaw) {
     ThreeByThree rotation_around_z;
     rotation_around_z.values[0][0] = cos(yaw);
     rotation_around_z.values[0][1] = sin(yaw);
@@ -147,7 +147,7 @@ void ThreeByOne::rotateYaw(double yaw) {
     mult_three_by_three(rotation_around_z);
 }
 
-void ThreeByOne::rotatePitch(double pitch) { 
+void ThreeByOne::rotatePitch(scalar_t pitch) { 
     ThreeByThree rotation_around_y;
     rotation_around_y.values[0][0] = cos(pitch);
     rotation_around_y.values[0][1] = 0;
@@ -160,7 +160,7 @@ void ThreeByOne::rotatePitch(double pitch) {
     rotation_around_y.values[2][2] = cos(pitch);
     mult_three_by_three(rotation_around_y);
 }
-void ThreeByOne::rotateRoll(double roll) {
+void ThreeByOne::rotateRoll(scalar_t roll) {
     ThreeByThree rotation_around_x;
     rotation_around_x.values[0][0] = 1;
     rotation_around_x.values[0][1] = 0;
@@ -187,24 +187,24 @@ ThreeByOne ThreeByOne::operator+(const ThreeByOne& addend) {
 }
 
 void ThreeByOne::operator-=(const ThreeByOne& subtrahend) {
-    values[0] += subtrahend.values[0];
-    values[1] += subtrahend.values[1];
-    values[2] += subtrahend.values[2];
+    values[0] -= subtrahend.values[0];
+    values[1] -= subtrahend.values[1];
+    values[2] -= subtrahend.values[2];
 }
 
 ThreeByOne ThreeByOne::operator-(const ThreeByOne& subtrahend) {
     ThreeByOne result = ThreeByOne(values[0], values[1], values[2]);
-    result += subtrahend;
+    result -= subtrahend;
     return result;
 }
 
-void ThreeByOne::operator/=(double divisor) {
+void ThreeByOne::operator/=(scalar_t divisor) {
     values[0] /= divisor;
     values[1] /= divisor;
     values[2] /= divisor;
 }
 
-ThreeByOne ThreeByOne::operator/(double divisor){
+ThreeByOne ThreeByOne::operator/(scalar_t divisor){
     ThreeByOne result = ThreeByOne(values[0], values[1], values[2]);
     result /= divisor;
     return result;
@@ -220,7 +220,7 @@ _Bool ThreeByOne::operator<(ThreeByOne& right) {
 }
 
 _Bool ThreeByOne::operator==(ThreeByOne& right) {
-    if ((fabs(values[0] - right.values[0]) + fabs(values[1] - right.values[1]) + fabs(values[2] - right.values[2])) < 0.1) {
+    if ((fabs(values[0] - right.values[0]) + fabs(values[1] - right.values[1]) + fabs(values[2] - right.values[2])) < 0.1f) {
         return true;
     }
     return false;
@@ -231,7 +231,7 @@ _Bool ThreeByOne::operator!=(ThreeByOne& right) {
 
 }
 
-void ThreeByOne::floorDivide(double divisor) {
+void ThreeByOne::floorDivide(scalar_t divisor) {
     values[0] = floor(values[0] / divisor);
     values[1] = floor(values[0] / divisor);
     values[2] = floor(values[0] / divisor);
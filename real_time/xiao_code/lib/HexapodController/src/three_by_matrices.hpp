@@ -3,35 +3,36 @@
  
 #include <stdint.h>
 #include <stdbool.h>
+#include "scalar.hpp"
 
 class ThreeByThree {
     public:
-        double values[3][3];
+        scalar_t values[3][3];
         void mult_left_three_by_three(const ThreeByThree& left);
         void mult_right_three_by_three(const ThreeByThree& right);
         void invert();
-        double value(uint8_t row, uint8_t collumn);
+        scalar_t value(uint8_t row, uint8_t collumn);
     private:
 };
 
 class ThreeByOne {
     public:
         ThreeByOne();
-        ThreeByOne(double value0, double value1, double value2);
-        ThreeByOne(double values[3]);
+        ThreeByOne(scalar_t value0, scalar_t value1, scalar_t value2);
+        ThreeByOne(scalar_t values[3]);
         ThreeByOne(const ThreeByOne& orig);
-        double values[3];
+        scalar_t values[3];
         void mult_three_by_three(const ThreeByThree& left);
-        void rotateYaw(double yaw);
-        void rotatePitch(double pitch);
-        void rotateRoll(double roll);
-        double magnitude();
+        void rotateYaw(scalar_t yaw);
+        void rotatePitch(scalar_t pitch);
+        void rotateRoll(scalar_t roll);
+        scalar_t magnitude();
         void operator+=(const ThreeByOne& addend);
         ThreeByOne operator+(const ThreeByOne& addend);
-        void operator/=(double divisor);
-        ThreeByOne operator/(double divisor);
-        void operator*=(double multiplier);
-        ThreeByOne operator*(double multiplier);
+        void operator/=(scalar_t divisor);
+        ThreeByOne operator/(scalar_t divisor);
+        void operator*=(scalar_t multiplier);
+        ThreeByOne operator*(scalar_t multiplier);
         void operator-=(const ThreeByOne& subtrahend);
         ThreeByOne operator-(const ThreeByOne& subtrahend);
         _Bool operator>(ThreeByOne& right);
@@ -39,7 +40,7 @@ class ThreeByOne {
         _Bool operator!=(ThreeByOne& right);
         _Bool operator==(ThreeByOne& right);
         ThreeByOne unit_vector();
-        void floorDivide(double divisor);
+        void floorDivide(scalar_t divisor);
     private:
 };
 
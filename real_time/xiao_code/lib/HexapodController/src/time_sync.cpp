@@ -0,0 +1,142 @@
+#include "time_sync.hpp"
+
+// correction gains per window: share of the error taken out of the offset,
+// and of the error per microsecond of window folded into the drift
+#define TIME_SYNC_OFFSET_GAIN 0.5f
+#define TIME_SYNC_DRIFT_GAIN 0.05f
+
+void TimeSync::onSync(uint32_t bus_us, uint8_t sequence, uint32_t local_us) {
+    if (_syncs > 0) {
+        _missed += static_cast<uint8_t>(sequence - _last_sequence - 1);
+    }
+    _last_sequence = sequence;
+    _syncs++;
+    uint32_t now_ms = millis();
+    _Bool coasted = now_ms - _last_sync_ms > TIME_SYNC_HOLDOVER_MS;
+    _last_sync_ms = now_ms;
+
+    if (_state == TIME_SYNC_NONE) {
+        _restart(bus_us, local_us);
+        return;
+    }
+    if (coasted) {
+        // back from holdover: keep the estimate, but it has to earn the lock again
+        _state = TIME_SYNC_ACQUIRING;
+        _window_count = 0;
+        _good_windows = 0;
+        _outlier_windows = 0;
+    }
+
+    // bus time minus estimate, a late read makes it more negative
+    int32_t error = static_cast<int32_t>(bus_us - toBus(local_us));
+    if (_window_count == 0 || error > _window_best) {
+        _window_best = error;
+        _window_best_bus = bus_us;
+        _window_best_local = local_us;
+    }
+    if (_window_count == 0) {
+        _window_start_local = local_us;
+    }
+    if (++_window_count < TIME_SYNC_WINDOW) {
+        return;
+    }
+
+    // end of window, correct from its least delayed frame
+    _window_count = 0;
+    uint32_t magnitude = _window_best >= 0 ? _window_best : -_window_best;
+    if (magnitude > TIME_SYNC_STEP_US) {
+        // one window with every frame held up is ignored, a second means a real jump
+        if (++_outlier_windows >= 2) {
+            _steps++;
+            _restart(_window_best_bus, _window_best_local);
+        }
+        return;
+    }
+    _outlier_windows = 0;
+    _last_error = _window_best;
+    if (magnitude > _max_error) {
+        _max_error = magnitude;
+    }
+    float window_us = static_cast<float>(local_us - _window_start_local);
+    uint32_t estimate = toBus(_window_best_local);
+    _bus_ref = estimate + static_cast<int32_t>(TIME_SYNC_OFFSET_GAIN * static_cast<float>(_window_best));
+    _local_ref = _window_best_local;
+    if (window_us > 0.0f) {
+        _drift += TIME_SYNC_DRIFT_GAIN * static_cast<float>(_window_best) / window_us;
+    }
+
+    if (magnitude <= TIME_SYNC_LOCK_US) {
+        if (_good_windows < TIME_SYNC_LOCK_WINDOWS) {
+            _good_windows++;
+        }
+    }
+    else {
+        _good_windows = 0;
+    }
+    _state = _good_windows >= TIME_SYNC_LOCK_WINDOWS ? TIME_SYNC_LOCKED : TIME_SYNC_ACQUIRING;
+}
+
+void TimeSync::_restart(uint32_t bus_us, uint32_t local_us) {
+    _bus_ref = bus_us;
+    _local_ref = local_us;
+    _window_count = 0;
+    _good_windows = 0;
+    _outlier_windows = 0;
+    _state = TIME_SYNC_ACQUIRING;
+}
+
+uint32_t TimeSync::toBus(uint32_t local_us) const {
+    int32_t elapsed = static_cast<int32_t>(local_us - _local_ref);
+    return _bus_ref + elapsed + static_cast<int32_t>(static_cast<float>(elapsed) * _drift);
+}
+
+uint32_t TimeSync::toLocal(uint32_t bus_us) const {
+    int32_t elapsed = static_cast<int32_t>(bus_us - _bus_ref);
+    return _local_ref + static_cast<int32_t>(static_cast<float>(elapsed) / (1.0f + _drift));
+}
+
+_Bool TimeSync::isValid() const {
+    return _state != TIME_SYNC_NONE;
+}
+
+TimeSyncState TimeSync::getState() const {
+    if (_state != TIME_SYNC_NONE && millis() - _last_sync_ms > TIME_SYNC_HOLDOVER_MS) {
+        return TIME_SYNC_HOLDOVER;
+    }
+    return _state;
+}
+
+int32_t TimeSync::getLastError() const {
+    return _last_error;
+}
+
+uint32_t TimeSync::getMaxError() const {
+    return _max_error;
+}
+
+float TimeSync::getDrift() const {
+    return _drift;
+}
+
+uint32_t TimeSync::getSyncs() const {
+    return _syncs;
+}
+
+uint32_t TimeSync::getMissed() const {
+    return _missed;
+}
+
+uint32_t TimeSync::getSteps() const {
+    return _steps;
+}
+
+void TimeSync::resetStats() {
+    _max_error = 0;
+}
+
+void TimeSync::print() {
+    static const char* const names[] = {"none", "acquiring", "locked", "holdover"};
+    Serial.printf("Time sync: %s, error %ld us (max %lu), drift %.2f ppm\n",
+        names[getState()], _last_error, _max_error, static_cast<double>(_drift * 1e6f));
+    Serial.printf("  %lu SYNC frames, %lu missed, %lu restarts\n", _syncs, _missed, _steps);
+}
@@ -0,0 +1,84 @@
+/**
+ * @file time_sync.hpp
+ * @brief Leg clock disciplined to the host's bus time from CAN SYNC broadcasts
+ *
+ * The host broadcasts a SYNC frame (TIME_SYNC_CAN_ID) carrying its bus time in
+ * microseconds. Every leg receives the same frame at the same instant, so an
+ * estimate built from it agrees across legs even though the host's own send
+ * time jitters. Execute times in commands are bus times and are mapped onto
+ * the leg's micros() with toLocal().
+ *
+ * The frame is timestamped when loop() reads it, which can only be late. So
+ * each window of TIME_SYNC_WINDOW frames is reduced to its least delayed
+ * sample, and that sample's error against the current estimate drives a
+ * proportional-integral correction of offset and drift. Errors beyond
+ * TIME_SYNC_STEP_US in two windows running restart the estimate, a single
+ * one is taken as a late read and skipped.
+ *
+ * Runs entirely from loop() on core0 (CAN handling and the command queue), so
+ * it takes no lock.
+ */
+
+#include <Arduino.h>
+#include <stdint.h>
+
+#ifndef HEX3_TIME_SYNC
+#define HEX3_TIME_SYNC
+
+    #define TIME_SYNC_CAN_ID 0x080              ///< SYNC broadcast, below every leg's ISO-TP ids
+    #define TIME_SYNC_WINDOW 4                  ///< SYNC frames per correction, 0.4 s at the host's 10 Hz
+    #define TIME_SYNC_STEP_US 2000              ///< larger errors restart the estimate
+    #define TIME_SYNC_LOCK_US 200               ///< windows within this count towards lock
+    #define TIME_SYNC_LOCK_WINDOWS 3
+    #define TIME_SYNC_HOLDOVER_MS 1000          ///< no SYNC for this long and the estimate is coasting
+
+    #define TIME_SYNC_CAN_COMMAND 0x24          ///< CMD_TIME_SYNC, status request and reply
+
+    enum TimeSyncState : uint8_t {
+        TIME_SYNC_NONE,                         ///< no SYNC seen, execute times are ignored
+        TIME_SYNC_ACQUIRING,
+        TIME_SYNC_LOCKED,
+        TIME_SYNC_HOLDOVER                      ///< SYNC stopped, still mapping with the last estimate
+    };
+
+    class TimeSync {
+        public:
+            /// A SYNC frame carrying bus_us was read at local_us (micros())
+            void onSync(uint32_t bus_us, uint8_t sequence, uint32_t local_us);
+            /// Leg micros() at bus time bus_us, only meaningful once isValid()
+            uint32_t toLocal(uint32_t bus_us) const;
+            uint32_t toBus(uint32_t local_us) const;
+            _Bool isValid() const;
+            TimeSyncState getState() const;
+            int32_t getLastError() const;       ///< us, bus minus estimate for the last window's best sample
+            uint32_t getMaxError() const;       ///< us, largest |error| since resetStats()
+            float getDrift() const;             ///< leg clock rate error, positive when the leg runs slow
+            uint32_t getSyncs() const;
+            uint32_t getMissed() const;         ///< SYNC sequence numbers skipped
+            uint32_t getSteps() const;
+            void resetStats();
+            void print();
+
+        private:
+            void _restart(uint32_t bus_us, uint32_t local_us);
+            uint32_t _bus_ref = 0;              ///< estimate: bus = _bus_ref + (local - _local_ref) * (1 + _drift)
+            uint32_t _local_ref = 0;
+            float _drift = 0.0f;
+            TimeSyncState _state = TIME_SYNC_NONE;
+            uint32_t _last_sync_ms = 0;
+            uint8_t _last_sequence = 0;
+            uint8_t _window_count = 0;
+            int32_t _window_best = 0;           ///< largest error in the window, the least delayed frame
+            uint32_t _window_best_bus = 0;
+            uint32_t _window_best_local = 0;
+            uint32_t _window_start_local = 0;
+            uint8_t _good_windows = 0;
+            uint8_t _outlier_windows = 0;
+            int32_t _last_error = 0;
+            uint32_t _max_error = 0;
+            uint32_t _syncs = 0;
+            uint32_t _missed = 0;
+            uint32_t _steps = 0;
+    };
+
+#endif
@@ -1,12 +1,17 @@
 #include "toe.hpp"
-#include <Wire.h>
+#include "i2c_bus.hpp"
 #include "log_levels.hpp"
 
 Toe::Toe(){}
 
-bool Toe::begin()
+bool Toe::begin(I2CBus& bus)
 {
-    Wire.setTimeout(20, true);
+    _bus = &bus;
+    _request.address = TOE_I2C_ADDR;
+    _request.channel = TOE_MUX_CHANNEL;
+    _request.priority = I2CPriority::BACKGROUND;
+
+    // setup runs before the sensing task, so the blocking library calls have the bus to themselves
     bool ok = sensor.begin();
     Serial.printf("toe idle is %f\n", toe_idle);
     #if LOG_LEVEL >= BASIC_DEBUG
@@ -31,11 +36,22 @@ bool Toe::begin()
     return true;
 }
 
+/**
+ * @brief Advance the toe state machine, never blocks
+ *
+ * Every register access is a low-priority request on the I2C bus scheduler, so
+ * it only runs in the gaps between encoder reads. At most one request is in
+ * flight; each call either waits for it or acts on its result.
+ */
 void Toe::update()
 {
-    // #if LOG_LEVEL >= BASIC_DEBUG
+    #if LOG_LEVEL >= CALCULATION_DEBUG
         Serial.printf("[Toe] update() called, state=%d\n", static_cast<int>(state));
-    // #endif
+    #endif
+    if (_requestBusy())
+    {
+        return;
+    }
     switch(state)
     {
         case ToeState::UNINITIALIZED:
@@ -61,63 +77,64 @@ void Toe::update()
                     return;
                 }
             }
-            
-            if (millis() - _last_read_ms > _read_interval_ms)
+
+            switch (_read_step)
             {
-                if (!sensor.isRangeComplete()) {
-                    // #if LOG_LEVEL >= BASIC_DEBUG
-                        Serial.println("[Toe] WARNING: sensor range not complete, skipping read");
-                    // #endif
-                    _unchanged_count++;
-                    if (_unchanged_count >= TOE_MAX_UNCHANGED_COUNT) {
-                        bool ok = sensor.begin();
-                        if (!ok) {
-                            #if LOG_LEVEL >= BASIC_DEBUG
-                                Serial.println("[Toe] ERROR: sensor.begin failed during reset, check wiring and I2C address");
-                            #endif
-                            state = ToeState::ERROR;
-                            return;
+                case ToeReadStep::IDLE:
+                    if (millis() - _last_read_ms > _read_interval_ms)
+                    {
+                        if (_submitRead(VL6180X_RESULT_INTERRUPT_STATUS_GPIO))
+                        {
+                            _read_step = ToeReadStep::CHECK_STATUS;
                         }
-                        
-                        state = ToeState::RESET_1;
-                        _last_action_time = millis();
-                        _unchanged_count = 0;
                     }
-                    return;
-                }
-                _last_read_ms = millis();
+                    break;
 
-                
-                uint8_t raw = medianFilter(sensor.readRangeResult());
-                float new_val = (float)raw;
-                if (!_first_read)
-                {
-                    // first valid reading, initialize _last_range directly to avoid startup spikes
-                    _last_range = new_val;
-                    _first_read = true;
-                }
-                else
-                {
-                    if (fabs(new_val - _last_range) < 0.001f) {
-                        _unchanged_count++;
-                    } else {
-                        _unchanged_count = 0;
+                case ToeReadStep::CHECK_STATUS:
+                    if (_request.status != I2CStatus::DONE)
+                    {
+                        _read_step = ToeReadStep::IDLE;
+                        break;
                     }
-                    if (_unchanged_count >= TOE_MAX_UNCHANGED_COUNT) {
-                        bool ok = sensor.begin();
-                        if (!ok) {
-                            #if LOG_LEVEL >= BASIC_DEBUG
-                                Serial.println("[Toe] ERROR: sensor.begin failed during reset, check wiring and I2C address");
-                            #endif
-                            state = ToeState::ERROR;
-                            return;
+                    if ((_request.rx[0] & 0x07) != 0x04)
+                    {
+                        #if LOG_LEVEL >= CALCULATION_DEBUG
+                            Serial.println("[Toe] WARNING: sensor range not complete, skipping read");
+                        #endif
+                        _read_step = ToeReadStep::IDLE;
+                        _unchanged_count++;
+                        if (_unchanged_count >= TOE_MAX_UNCHANGED_COUNT) {
+                            _startReset();
                         }
-                        state = ToeState::RESET_1;
-                        _last_action_time = millis();
-                        _unchanged_count = 0;
+                        break;
+                    }
+                    _last_read_ms = millis();
+                    if (_submitRead(VL6180X_RESULT_RANGE_VAL))
+                    {
+                        _read_step = ToeReadStep::READ_RANGE;
                     }
-                    _last_range = 0.5f * _last_range + 0.5f * new_val;
+                    else
+                    {
+                        _read_step = ToeReadStep::IDLE;
+                    }
+                    break;
+
+                case ToeReadStep::READ_RANGE:
+                {
+                    if (_request.status != I2CStatus::DONE)
+                    {
+                        _read_step = ToeReadStep::IDLE;
+                        break;
+                    }
+                    uint8_t raw = _request.rx[0];
+                    _read_step = _submitWrite(VL6180X_SYSTEM_INTERRUPT_CLEAR, 0x07) ? ToeReadStep::CLEAR_INTERRUPT : ToeReadStep::IDLE;
+                    _processRange(raw);
+                    break;
                 }
+
+                case ToeReadStep::CLEAR_INTERRUPT:
+                    _read_step = ToeReadStep::IDLE;
+                    break;
             }
             break;
         }
@@ -125,22 +142,31 @@ void Toe::update()
             // _last_range = toe_idle; // reset to idle during reset
             // TODO: Fix this reset sequence, it causes the rp2350 to reboot
             if (millis() - _last_action_time > TOE_RESET_ACTION_DELAY_MS) {
-                sensor.stopRangeContinuous();
-                state = ToeState::RESET_2;
-                _last_action_time = millis();
+                // stop continuous ranging
+                if (_submitWrite(VL6180X_SYSRANGE_START, 0x01)) {
+                    state = ToeState::RESET_2;
+                    _last_action_time = millis();
+                }
             }
             break;
 
         case ToeState::RESET_2:
             if (millis() - _last_action_time > TOE_RESET_ACTION_DELAY_MS) {
-                sensor.startRangeContinuous(10);
-                _last_action_time = millis();
-                state = ToeState::RESET_3;
+                // restart continuous ranging at 10 ms: period register first, then start
+                if (!_period_written) {
+                    _period_written = _submitWrite(VL6180X_SYSRANGE_INTERMEASUREMENT_PERIOD, 0);
+                }
+                else if (_submitWrite(VL6180X_SYSRANGE_START, 0x03)) {
+                    _period_written = false;
+                    _last_action_time = millis();
+                    state = ToeState::RESET_3;
+                }
             }
             break;
         case ToeState::RESET_3:
             if (millis() - _last_action_time > TOE_RESET_ACTION_DELAY_MS) {
                 _last_action_time = millis();
+                _read_step = ToeReadStep::IDLE;
                 state = ToeState::OPERATING;
             }
             break;
@@ -157,7 +183,6 @@ void Toe::update()
             break;
     }
 
-    
     // -------------------------
     // CALIBRATION MODE -- collects samples to determine toe_idle at startup. User will copy stable reading to config.hpp TOE_IDLE_READ for future runs.
     // -------------------------
@@ -221,6 +246,84 @@ float Toe::read()
     return _last_range;
 }
 
+/**
+ * @brief Filter a new range sample into the cached value and watch for a stuck sensor
+ */
+void Toe::_processRange(uint8_t raw_range)
+{
+    uint8_t raw = medianFilter(raw_range);
+    float new_val = (float)raw;
+    if (!_first_read)
+    {
+        // first valid reading, initialize _last_range directly to avoid startup spikes
+        _last_range = new_val;
+        _first_read = true;
+        return;
+    }
+    if (fabs(new_val - _last_range) < 0.001f) {
+        _unchanged_count++;
+    } else {
+        _unchanged_count = 0;
+    }
+    if (_unchanged_count >= TOE_MAX_UNCHANGED_COUNT) {
+        _startReset();
+    }
+    _last_range = 0.5f * _last_range + 0.5f * new_val;
+}
+
+/**
+ * @brief Restart continuous ranging through RESET_1..3
+ *
+ * Replaces the blocking sensor.begin() re-initialisation, which held the bus for
+ * several milliseconds of register writes.
+ */
+void Toe::_startReset()
+{
+    state = ToeState::RESET_1;
+    _read_step = ToeReadStep::IDLE;
+    _period_written = false;
+    _last_action_time = millis();
+    _unchanged_count = 0;
+}
+
+bool Toe::_requestBusy()
+{
+    return _bus != nullptr && _bus->isPending(_request);
+}
+
+/// Queue a single-byte read of a 16-bit VL6180X register
+bool Toe::_submitRead(uint16_t reg)
+{
+    if (_bus == nullptr)
+    {
+        return false;
+    }
+    _request.tx[0] = reg >> 8;
+    _request.tx[1] = reg & 0xFF;
+    _request.tx_len = 2;
+    _request.rx_len = 1;
+    _request.release_us = micros();
+    _request.deadline_us = micros() + static_cast<uint32_t>(_read_interval_ms * 1000);
+    return _bus->submit(_request);
+}
+
+/// Queue a single-byte write to a 16-bit VL6180X register
+bool Toe::_submitWrite(uint16_t reg, uint8_t value)
+{
+    if (_bus == nullptr)
+    {
+        return false;
+    }
+    _request.tx[0] = reg >> 8;
+    _request.tx[1] = reg & 0xFF;
+    _request.tx[2] = value;
+    _request.tx_len = 3;
+    _request.rx_len = 0;
+    _request.release_us = micros();
+    _request.deadline_us = micros() + static_cast<uint32_t>(_read_interval_ms * 1000);
+    return _bus->submit(_request);
+}
+
 uint8_t Toe::medianFilter(uint8_t sample)
 {
     _median_buffer[_median_index] = sample;
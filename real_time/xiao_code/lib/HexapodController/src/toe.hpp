@@ -8,10 +8,23 @@
     #include <Adafruit_VL6180X.h>
     #include "config.hpp"
     #include "user_config.hpp"
+    #include "i2c_bus.hpp"
 
     #define TOE_MAX_UNCHANGED_COUNT 20 // number of consecutive readings that are unchanged before reinitializing sensor
     #define TOE_RESET_ACTION_DELAY_MS 50
 
+    #define TOE_I2C_ADDR 0x29
+    #ifndef TOE_MUX_CHANNEL
+        #define TOE_MUX_CHANNEL I2C_NO_CHANNEL // VL6180X sits on the main bus, not behind the multiplexer
+    #endif
+
+    // VL6180X registers used by the non-blocking update path
+    #define VL6180X_SYSTEM_INTERRUPT_CLEAR 0x015
+    #define VL6180X_SYSRANGE_START 0x018
+    #define VL6180X_SYSRANGE_INTERMEASUREMENT_PERIOD 0x01B
+    #define VL6180X_RESULT_INTERRUPT_STATUS_GPIO 0x04F
+    #define VL6180X_RESULT_RANGE_VAL 0x062
+
     enum class ToeState {
         UNINITIALIZED,
         OPERATING,
@@ -20,11 +33,19 @@
         RESET_3,
         ERROR
     };
+
+    /// Step of the register sequence for one range read in OPERATING
+    enum class ToeReadStep {
+        IDLE,
+        CHECK_STATUS,
+        READ_RANGE,
+        CLEAR_INTERRUPT
+    };
     class Toe
     {
         public:
             Toe();
-            bool begin();
+            bool begin(I2CBus& bus);
             void update();   //call regularly to update cached value, non-blocking
             float read();    // returns latest value
             bool isPressed();
@@ -58,6 +79,17 @@
             uint8_t _median_index = 0;
             uint8_t _median_count = 0;
             uint32_t _last_action_time = 0;
+
+            // all runtime register access goes through the bus scheduler at low priority
+            I2CBus* _bus = nullptr;
+            I2CRequest _request;
+            ToeReadStep _read_step = ToeReadStep::IDLE;
+            bool _period_written = false;
+            bool _submitRead(uint16_t reg);
+            bool _submitWrite(uint16_t reg, uint8_t value);
+            bool _requestBusy();
+            void _processRange(uint8_t raw);
+            void _startReset();
         };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,261 @@
+#include "trajectory.hpp"
+#include <math.h>
+
+/**
+ * A rest-to-rest profile that reaches speed v spends as long accelerating as
+ * decelerating and covers v * accel_time doing both. With the acceleration
+ * limit reached, accel_time = a / j + v / a; without it, 2 sqrt(v / j).
+ * If the move is too short to cruise at max_speed, v solves length = v * accel_time.
+ */
+void SCurveProfile::plan(scalar_t length, scalar_t max_speed, scalar_t max_acceleration, scalar_t max_jerk) {
+    _length = length > 0.0f ? length : 0.0f;
+    _jerk = max_jerk;
+    scalar_t speed = max_speed;
+    // fastest speed reachable in the distance, with and without the acceleration limit
+    scalar_t ramp_speed = max_acceleration * max_acceleration / max_jerk;   // speed gained over the two jerk ramps alone
+    scalar_t full_accel_time = speed >= ramp_speed
+        ? max_acceleration / max_jerk + speed / max_acceleration
+        : 2.0f * sqrt(speed / max_jerk);
+    if (speed * full_accel_time > _length) {
+        scalar_t a_over_j = max_acceleration / max_jerk;
+        speed = 0.5f * max_acceleration * (sqrt(a_over_j * a_over_j + 4.0f * _length / max_acceleration) - a_over_j);
+        if (speed < ramp_speed) {
+            speed = cbrt(0.25f * _length * _length * max_jerk);
+        }
+    }
+    _speed = speed;
+    if (speed >= ramp_speed) {
+        _jerk_time = max_acceleration / max_jerk;
+        _accel_time = _jerk_time + speed / max_acceleration;
+    }
+    else {
+        _jerk_time = sqrt(speed / max_jerk);
+        _accel_time = 2.0f * _jerk_time;
+    }
+    _peak_acceleration = _jerk * _jerk_time;
+    _cruise_time = speed > 0.0f ? _length / speed - _accel_time : 0.0f;
+    if (_cruise_time < 0.0f) {
+        _cruise_time = 0.0f;            // rounding only
+    }
+}
+
+void SCurveProfile::_sampleAcceleration(scalar_t t_s, scalar_t& distance, scalar_t& speed, scalar_t& acceleration) const {
+    if (t_s < _jerk_time) {
+        acceleration = _jerk * t_s;
+        speed = 0.5f * _jerk * t_s * t_s;
+        distance = _jerk * t_s * t_s * t_s / 6.0f;
+    }
+    else if (t_s < _accel_time - _jerk_time) {
+        acceleration = _peak_acceleration;
+        speed = _peak_acceleration * (t_s - 0.5f * _jerk_time);
+        distance = _peak_acceleration / 6.0f * (3.0f * t_s * t_s - 3.0f * _jerk_time * t_s + _jerk_time * _jerk_time);
+    }
+    else {
+        // the last jerk ramp mirrors the first, counted back from the end of the phase
+        scalar_t remaining = _accel_time - t_s;
+        acceleration = _jerk * remaining;
+        speed = _speed - 0.5f * _jerk * remaining * remaining;
+        distance = 0.5f * _speed * _accel_time - _speed * remaining + _jerk * remaining * remaining * remaining / 6.0f;
+    }
+}
+
+SCurvePhase SCurveProfile::sample(scalar_t t_s, scalar_t& distance, scalar_t& speed, scalar_t& acceleration) const {
+    if (t_s <= 0.0f) {
+        distance = speed = acceleration = 0.0f;
+        return SCURVE_ACCELERATING;
+    }
+    if (t_s >= duration()) {
+        distance = _length;
+        speed = acceleration = 0.0f;
+        return SCURVE_DONE;
+    }
+    if (t_s < _accel_time) {
+        _sampleAcceleration(t_s, distance, speed, acceleration);
+        return SCURVE_ACCELERATING;
+    }
+    if (t_s < _accel_time + _cruise_time) {
+        distance = 0.5f * _speed * _accel_time + _speed * (t_s - _accel_time);
+        speed = _speed;
+        acceleration = 0.0f;
+        return SCURVE_CRUISING;
+    }
+    // deceleration is the acceleration phase run backwards from the end
+    _sampleAcceleration(duration() - t_s, distance, speed, acceleration);
+    distance = _length - distance;
+    acceleration = -acceleration;
+    return SCURVE_DECELERATING;
+}
+
+scalar_t SCurveProfile::duration() const {
+    return 2.0f * _accel_time + _cruise_time;
+}
+
+scalar_t SCurveProfile::peakSpeed() const {
+    return _speed;
+}
+
+scalar_t SCurveProfile::accelTime() const {
+    return _accel_time;
+}
+
+scalar_t sCurveBlendOverlap(const SCurveProfile& current, const SCurveProfile& next, scalar_t reach) {
+    scalar_t high = current.accelTime() < next.accelTime() ? current.accelTime() : next.accelTime();
+    if (reach <= 0.0f || high <= 0.0f) {
+        return 0.0f;
+    }
+    scalar_t length, speed, acceleration;
+    current.sample(current.duration(), length, speed, acceleration);
+    // both distances grow with the overlap, bisect for the limit
+    scalar_t low = 0.0f;
+    for (uint8_t i = 0; i < 16; i++) {
+        scalar_t overlap = i == 0 ? high : 0.5f * (low + high);
+        scalar_t current_done, next_done;
+        // the toe is furthest from both lines about half way through the overlap
+        current.sample(current.duration() - 0.5f * overlap, current_done, speed, acceleration);
+        next.sample(0.5f * overlap, next_done, speed, acceleration);
+        if (length - current_done <= reach && next_done <= reach) {
+            if (i == 0) {
+                return overlap;         // the whole phase fits
+            }
+            low = overlap;
+        }
+        else {
+            high = overlap;
+        }
+    }
+    return low;
+}
+
+/**
+ * @brief Plan a segment from p0 to p2 shaped by p1
+ *
+ * @param duration_us Time from p0 to p2, at least 1 us
+ * @param start_us    micros() at which the toe is at p0, may be slightly in the past
+ * @param through     p1 is a point on the curve at half time rather than the control point
+ */
+void QuadraticSegment::start(const scalar_t p0[3], const scalar_t p1[3], const scalar_t p2[3],
+                             uint32_t duration_us, uint32_t start_us, _Bool through) {
+    for (uint8_t i = 0; i < 3; i++) {
+        _p0.values[i] = p0[i];
+        _p2.values[i] = p2[i];
+        // B(0.5) = (P0 + 2 P1 + P2) / 4, solved for the control point
+        _p1.values[i] = through ? 2.0f * p1[i] - 0.5f * (p0[i] + p2[i]) : p1[i];
+    }
+    _duration_us = duration_us > 0 ? duration_us : 1;
+    _start_us = start_us;
+    _active = true;
+}
+
+void QuadraticSegment::stop() {
+    _active = false;
+}
+
+_Bool QuadraticSegment::isActive() const {
+    return _active;
+}
+
+_Bool QuadraticSegment::evaluate(uint32_t now_us, TrajectoryPoint& point) {
+    int32_t elapsed = static_cast<int32_t>(now_us - _start_us);
+    if (!_active || elapsed >= static_cast<int32_t>(_duration_us)) {
+        _active = false;
+        point.pos = _p2;
+        point.vel = ThreeByOne(0.0f, 0.0f, 0.0f);
+        point.acc = ThreeByOne(0.0f, 0.0f, 0.0f);
+        return false;
+    }
+    scalar_t duration_s = static_cast<scalar_t>(_duration_us) * 1e-6f;
+    scalar_t s = elapsed > 0 ? static_cast<scalar_t>(elapsed) / static_cast<scalar_t>(_duration_us) : 0.0f;
+    scalar_t u = 1.0f - s;
+
+    ThreeByOne d01 = _p1 - _p0;
+    ThreeByOne d12 = _p2 - _p1;
+    point.pos = _p0 * (u * u) + _p1 * (2.0f * s * u) + _p2 * (s * s);
+    // dB/dt = 2 ((1-s)(P1-P0) + s(P2-P1)) / T, d2B/dt2 = 2 (P2 - 2 P1 + P0) / T^2
+    point.vel = (d01 * u + d12 * s) * (2.0f / duration_s);
+    point.acc = (d12 - d01) * (2.0f / (duration_s * duration_s));
+    return true;
+}
+
+void SetpointSpline::push(const scalar_t pos[3], uint32_t t_us) {
+    if (_count > 0) {
+        int32_t since_last = static_cast<int32_t>(t_us - _t_us[_count - 1]);
+        if (since_last > SETPOINT_SPLINE_MAX_GAP_US) {
+            _count = 0;
+        }
+        else if (since_last <= 0) {
+            // same instant, the later setpoint wins
+            _pos[_count - 1] = ThreeByOne(pos[0], pos[1], pos[2]);
+            return;
+        }
+    }
+    if (_count == SETPOINT_SPLINE_POINTS) {
+        for (uint8_t i = 1; i < SETPOINT_SPLINE_POINTS; i++) {
+            _pos[i - 1] = _pos[i];
+            _t_us[i - 1] = _t_us[i];
+        }
+        _count--;
+    }
+    _pos[_count] = ThreeByOne(pos[0], pos[1], pos[2]);
+    _t_us[_count] = t_us;
+    _count++;
+}
+
+void SetpointSpline::reset() {
+    _count = 0;
+}
+
+_Bool SetpointSpline::isActive() const {
+    return _count > 0;
+}
+
+/// Velocity at setpoint k in mm/s, central difference where both neighbours exist
+ThreeByOne SetpointSpline::_tangent(uint8_t k) {
+    uint8_t before = k > 0 ? k - 1 : k;
+    uint8_t after = k + 1 < _count ? k + 1 : k;
+    scalar_t span_s = static_cast<scalar_t>(_t_us[after] - _t_us[before]) * 1e-6f;
+    return (_pos[after] - _pos[before]) / span_s;
+}
+
+_Bool SetpointSpline::evaluate(uint32_t now_us, uint32_t delay_us, TrajectoryPoint& point) {
+    if (_count == 0) {
+        return false;
+    }
+    uint32_t t_us = now_us - delay_us;
+    if (static_cast<int32_t>(t_us - _t_us[0]) < 0) {
+        return false;
+    }
+    int32_t past_newest = static_cast<int32_t>(t_us - _t_us[_count - 1]);
+    if (past_newest >= 0) {
+        if (past_newest > SETPOINT_SPLINE_MAX_GAP_US) {
+            _count = 0;
+            return false;
+        }
+        point.pos = _pos[_count - 1];
+        point.vel = ThreeByOne(0.0f, 0.0f, 0.0f);
+        point.acc = ThreeByOne(0.0f, 0.0f, 0.0f);
+        return true;
+    }
+
+    uint8_t k = 0;
+    while (static_cast<int32_t>(t_us - _t_us[k + 1]) >= 0) {
+        k++;
+    }
+    scalar_t h = static_cast<scalar_t>(_t_us[k + 1] - _t_us[k]) * 1e-6f;
+    scalar_t s = static_cast<scalar_t>(t_us - _t_us[k]) * 1e-6f / h;
+    scalar_t s2 = s * s;
+    scalar_t s3 = s2 * s;
+    // tangents scaled to the unit interval
+    ThreeByOne m0 = _tangent(k) * h;
+    ThreeByOne m1 = _tangent(k + 1) * h;
+    ThreeByOne& p0 = _pos[k];
+    ThreeByOne& p1 = _pos[k + 1];
+
+    // cubic Hermite basis and its first and second derivatives in s
+    point.pos = p0 * (2.0f * s3 - 3.0f * s2 + 1.0f) + m0 * (s3 - 2.0f * s2 + s)
+              + p1 * (-2.0f * s3 + 3.0f * s2) + m1 * (s3 - s2);
+    point.vel = (p0 * (6.0f * s2 - 6.0f * s) + m0 * (3.0f * s2 - 4.0f * s + 1.0f)
+              + p1 * (-6.0f * s2 + 6.0f * s) + m1 * (3.0f * s2 - 2.0f * s)) / h;
+    point.acc = (p0 * (12.0f * s - 6.0f) + m0 * (6.0f * s - 4.0f)
+              + p1 * (-12.0f * s + 6.0f) + m1 * (6.0f * s - 2.0f)) / (h * h);
+    return true;
+}
@@ -0,0 +1,146 @@
+/**
+ * @file trajectory.hpp
+ * @brief Time-parameterised Cartesian curve segments evaluated on board
+ *
+ * A segment is planned once when its command starts and then sampled at the
+ * control rate, so the host sends one message per curve instead of a stream of
+ * RAPID setpoints. Sampling gives the toe position together with its velocity
+ * and acceleration for the joint feedforward.
+ *
+ * Times are micros() values compared by signed difference, so a segment may
+ * straddle the 71 minute wrap.
+ *
+ * SCurveProfile      jerk-limited speed profile along a straight linear move
+ * QuadraticSegment   one CMD_QUADRATIC_MOVE
+ * SetpointSpline     RAPID setpoints smoothed at the control rate (RAPID_INTERPOLATION)
+ */
+
+#include <stdint.h>
+#include "scalar.hpp"
+#include "three_by_matrices.hpp"
+#include "user_config.hpp"
+
+#ifndef HEX3_TRAJECTORY
+#define HEX3_TRAJECTORY
+
+    #ifndef RAPID_INTERPOLATION
+        #define RAPID_INTERPOLATION false
+    #endif
+    #ifndef RAPID_INTERPOLATION_DELAY_US
+        #define RAPID_INTERPOLATION_DELAY_US 20000  ///< two 10 ms host periods, keeps a setpoint ahead of the one being approached
+    #endif
+    #define SETPOINT_SPLINE_POINTS 6                ///< delay plus jitter must stay within this many setpoint periods
+    #define SETPOINT_SPLINE_MAX_GAP_US 100000       ///< longer silence ends the spline, the next setpoint starts a new one
+
+    /// Cartesian sample of a segment: mm, mm/s, mm/s^2
+    struct TrajectoryPoint {
+        ThreeByOne pos;
+        ThreeByOne vel;
+        ThreeByOne acc;
+    };
+
+    /// Phase of an SCurveProfile at a given time
+    enum SCurvePhase : uint8_t {
+        SCURVE_ACCELERATING,
+        SCURVE_CRUISING,
+        SCURVE_DECELERATING,
+        SCURVE_DONE
+    };
+
+    /**
+     * @brief Rest-to-rest double-S profile, distance as a closed-form function of time
+     *
+     * Acceleration ramps at the jerk limit, holds the acceleration limit, ramps
+     * back to zero at the cruise speed; deceleration mirrors it. A short move
+     * or a low limit drops the constant acceleration or cruise phase and
+     * lowers the peak speed to fit. Sampling never accumulates, so the end is
+     * reached exactly at duration().
+     */
+    class SCurveProfile {
+        public:
+            /// Plan a move of length mm, limits in mm/s, mm/s^2, mm/s^3
+            void plan(scalar_t length, scalar_t max_speed, scalar_t max_acceleration, scalar_t max_jerk);
+            /// Distance, speed and acceleration along the move t_s after it started
+            SCurvePhase sample(scalar_t t_s, scalar_t& distance, scalar_t& speed, scalar_t& acceleration) const;
+            scalar_t duration() const;
+            scalar_t peakSpeed() const;
+            /// Length of the acceleration phase, the same as the deceleration phase
+            scalar_t accelTime() const;
+
+        private:
+            /// First half of the profile, 0 <= t_s <= _accel_time
+            void _sampleAcceleration(scalar_t t_s, scalar_t& distance, scalar_t& speed, scalar_t& acceleration) const;
+            scalar_t _length = 0.0f;
+            scalar_t _speed = 0.0f;             ///< cruise speed actually reached
+            scalar_t _jerk = 0.0f;
+            scalar_t _peak_acceleration = 0.0f;
+            scalar_t _jerk_time = 0.0f;         ///< each jerk ramp
+            scalar_t _accel_time = 0.0f;        ///< whole acceleration phase, jerk ramps included
+            scalar_t _cruise_time = 0.0f;
+    };
+
+    /**
+     * @brief Overlap for blending one S-curve move into the next, in seconds
+     *
+     * The next move starts this long before the current one ends and the two
+     * displacements add, so the toe rounds the corner without stopping. The
+     * overlap is the longest, up to the shorter of the current move's
+     * deceleration and the next move's acceleration, for which half way
+     * through it the current move still has at most reach mm to go and the
+     * next has covered at most reach mm. Around a corner turning by angle a
+     * the toe then passes about reach * sin(a) from the corner point.
+     */
+    scalar_t sCurveBlendOverlap(const SCurveProfile& current, const SCurveProfile& next, scalar_t reach);
+
+    /**
+     * @brief Quadratic Bézier from the current toe position
+     *
+     * B(s) = (1-s)^2 P0 + 2 s (1-s) P1 + s^2 P2 with s = (t - start) / duration.
+     * The curve leaves P0 towards P1 and arrives at P2 coming from P1; with
+     * through set, P1 is instead a point the curve passes at half time.
+     */
+    class QuadraticSegment {
+        public:
+            void start(const scalar_t p0[3], const scalar_t p1[3], const scalar_t p2[3],
+                       uint32_t duration_us, uint32_t start_us, _Bool through);
+            void stop();
+            _Bool isActive() const;
+            /// Sample at now_us, false once the segment has ended (point is then the end, at rest)
+            _Bool evaluate(uint32_t now_us, TrajectoryPoint& point);
+
+        private:
+            ThreeByOne _p0;
+            ThreeByOne _p1;
+            ThreeByOne _p2;
+            uint32_t _start_us = 0;
+            uint32_t _duration_us = 0;
+            _Bool _active = false;
+    };
+
+    /**
+     * @brief Catmull-Rom spline through a stream of timestamped setpoints
+     *
+     * Sampled delay_us in the past, so the segment being followed normally
+     * has a setpoint after it. Between setpoints k and k+1 it is the cubic
+     * Hermite with tangents (p[k+1] - p[k-1]) / (t[k+1] - t[k-1]), which copes
+     * with uneven arrival times; at either end of the buffer the tangent
+     * falls back to the one-sided difference. Once the delayed time passes
+     * the newest setpoint the spline holds it at rest.
+     */
+    class SetpointSpline {
+        public:
+            /// Add a setpoint, t_us no earlier than the previous one
+            void push(const scalar_t pos[3], uint32_t t_us);
+            void reset();
+            _Bool isActive() const;
+            /// Sample at now_us - delay_us, false before the first setpoint or after the stream went quiet
+            _Bool evaluate(uint32_t now_us, uint32_t delay_us, TrajectoryPoint& point);
+
+        private:
+            ThreeByOne _pos[SETPOINT_SPLINE_POINTS];    ///< oldest first
+            uint32_t _t_us[SETPOINT_SPLINE_POINTS];
+            uint8_t _count = 0;
+            ThreeByOne _tangent(uint8_t k);
+    };
+
+#endif
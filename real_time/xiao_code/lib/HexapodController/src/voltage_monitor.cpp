@@ -6,28 +6,28 @@
 #include "config.hpp"
 #include "log_levels.hpp"
 
-VoltageSensor::VoltageSensor(uint8_t sense_pin, double voltage_divider_factor) {
+VoltageSensor::VoltageSensor(uint8_t sense_pin, float voltage_divider_factor) {
     _sense_pin = sense_pin;
     _voltage_divider_factor = voltage_divider_factor;
     pinMode(_sense_pin, INPUT); //INPUT_DISABLE
 }
 
-double VoltageSensor::directRead() {
+float VoltageSensor::directRead() {
     return analogRead(_sense_pin) * _voltage_divider_factor; 
 }
 
-double VoltageSensor::filteredRead() {
-    if (millis() - _last_read_time < 10) {
-        return _voltage; // Return last value if less than 1s since last read
-    }
-    _last_read_time = millis();
-    if (_voltage < 0.01) {
+// Call every VOLTAGE_FILTER_INTERVAL_MS (sensing scheduler task)
+void VoltageSensor::update() {
+    if (_voltage < 0.01f) {
         _voltage = directRead(); // Initialize voltage if it is less than 0.01V
     }
-    _voltage = round2(directRead() * 1.0 / NUM_MEASUREMENTS + _voltage * (NUM_MEASUREMENTS - 1.0) / NUM_MEASUREMENTS);
+    _voltage = round2(directRead() * 1.0f / NUM_MEASUREMENTS + _voltage * (NUM_MEASUREMENTS - 1.0f) / NUM_MEASUREMENTS);
+}
+
+float VoltageSensor::filteredRead() {
     return _voltage;
 }
 
-double VoltageSensor::round2(double value) {
-    return (int)(value * 100 + 0.5) / 100.0;
+float VoltageSensor::round2(float value) {
+    return (int)(value * 100 + 0.5f) / 100.0f;
 }
\ No newline at end of file
@@ -2,25 +2,26 @@
 #include <stdint.h>
 #include <stdbool.h>
 #define VSENSE_PIN D1 
-#define VSENSE_FACTOR ((3.3 / 1023) / .138)
+#define VSENSE_FACTOR ((3.3f / 1023) / .138f)
 
 #ifndef VOLT_SENSE
 #define VOLT_SENSE
 
     #define NUM_MEASUREMENTS 50
+    #define VOLTAGE_FILTER_INTERVAL_MS 10   // update() period, sets the filter time constant (NUM_MEASUREMENTS samples)
 
     class VoltageSensor {
         public:
-            VoltageSensor(uint8_t sense_pin=VSENSE_PIN, double voltage_divider_factor=VSENSE_FACTOR);
-            double filteredRead();
-            double directRead();
+            VoltageSensor(uint8_t sense_pin=VSENSE_PIN, float voltage_divider_factor=VSENSE_FACTOR);
+            void update();
+            float filteredRead();
+            float directRead();
 
         private:
-            uint32_t _last_read_time = 0;
-            double _voltage = -1.0; // Initialize to -1.0 to indicate uninitialized
+            float _voltage = -1.0; // Initialize to -1.0 to indicate uninitialized
             uint8_t _sense_pin;
-            double _voltage_divider_factor;
-            double round2(double value);
+            float _voltage_divider_factor;
+            float round2(float value);
     };
 
 #endif
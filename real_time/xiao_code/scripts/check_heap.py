@@ -0,0 +1,140 @@
+"""
+Post-link check that the control path never reaches the heap.
+
+Disassembles the firmware ELF, builds the direct call graph (bl, blx and
+tail-call branches) and walks it from the control-path entry points below.
+If any allocator is reachable the build fails and the offending call chain
+is printed.
+
+Only direct calls are followed. Calls through function pointers, virtual
+methods and the scheduler's task table are not seen, so a task body has to
+be listed as a root to be checked. Functions the compiler inlined into
+their caller are checked as part of that caller.
+
+Set `custom_heap_check = warn` in platformio.ini to report without failing,
+or `custom_heap_check = off` to skip the check.
+
+Can also be run by hand against any ELF:
+    python3 scripts/check_heap.py .pio/build/seeed_xiao_rp2350/firmware.elf [objdump]
+"""
+
+import re
+import subprocess
+import sys
+
+CONTROL_ROOTS = [
+    "Leg::_controlStep",
+    "Leg::_controlAlarm",
+    "Leg::runSpeed",
+    "Leg::linearMovePerform",
+    "Leg::processCommandQueue",
+    "Leg::_updateKinematics",
+    "Axis::momentumMonitor",
+    "Sensing::update",
+    "PwmDriver::latch",
+]
+
+ALLOCATORS = {
+    "malloc", "_malloc_r", "__wrap_malloc",
+    "calloc", "_calloc_r", "__wrap_calloc",
+    "realloc", "_realloc_r", "__wrap_realloc",
+    "memalign", "_memalign_r",
+    "operator new", "operator new[]",
+}
+
+_FUNCTION_RE = re.compile(r"^[0-9a-f]+ <(.+)>:$")
+_CALL_RE = re.compile(r"\s(?:bl|blx|b\.w|b|call|jmp)\s+[0-9a-f]+ <([^>]+)>")
+
+
+def _base_name(symbol):
+    """Strip the parameter list and any @plt suffix from a demangled symbol."""
+    symbol = symbol.split("@")[0]
+    if symbol.endswith(" const"):
+        symbol = symbol[:-len(" const")]
+    if not symbol.endswith(")"):
+        return symbol
+    depth = 0
+    for i in range(len(symbol) - 1, -1, -1):
+        if symbol[i] == ")":
+            depth += 1
+        elif symbol[i] == "(":
+            depth -= 1
+            if depth == 0:
+                return symbol[:i]
+    return symbol
+
+
+def call_graph(elf, objdump):
+    """Map each function to the set of functions it calls directly."""
+    output = subprocess.run([objdump, "-d", "-C", "--no-show-raw-insn", elf],
+                            check=True, capture_output=True, text=True).stdout
+    graph = {}
+    callees = None
+    for line in output.splitlines():
+        match = _FUNCTION_RE.match(line)
+        if match:
+            callees = graph.setdefault(_base_name(match.group(1)), set())
+            continue
+        if callees is None:
+            continue
+        match = _CALL_RE.search(line)
+        # "<func+0x1a>" is a branch inside a function, not a call
+        if match and "+0x" not in match.group(1):
+            callees.add(_base_name(match.group(1)))
+    return graph
+
+
+def find_heap_paths(graph, roots):
+    """Return (missing roots, call chains from a root to an allocator)."""
+    missing = [root for root in roots if root not in graph]
+    paths = []
+    for root in roots:
+        if root not in graph:
+            continue
+        parent = {root: None}
+        pending = [root]
+        while pending:
+            function = pending.pop()
+            for callee in graph.get(function, ()):
+                if callee in parent:
+                    continue
+                parent[callee] = function
+                if callee in ALLOCATORS:
+                    chain = [callee]
+                    while parent[chain[-1]] is not None:
+                        chain.append(parent[chain[-1]])
+                    paths.append(" -> ".join(reversed(chain)))
+                else:
+                    pending.append(callee)
+    return missing, paths
+
+
+def check(elf, objdump, log=print):
+    """Log the result and return True if no allocator is reachable."""
+    missing, paths = find_heap_paths(call_graph(elf, objdump), CONTROL_ROOTS)
+    for root in missing:
+        log("check_heap: %s not found (inlined or not built), skipped" % root)
+    for path in paths:
+        log("check_heap: heap reachable from control path: %s" % path)
+    if not paths:
+        log("check_heap: no allocator reachable from %d control-path roots"
+            % (len(CONTROL_ROOTS) - len(missing)))
+    return not paths
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        sys.exit("usage: check_heap.py <elf> [objdump]")
+    sys.exit(0 if check(sys.argv[1], sys.argv[2] if len(sys.argv) > 2 else "objdump") else 1)
+else:
+    Import("env")  # noqa: F821 (provided by PlatformIO's SCons environment)
+
+    def _post_link(source, target, env):
+        mode = env.GetProjectOption("custom_heap_check", "error")
+        if mode == "off":
+            return
+        objdump = env.subst("$OBJCOPY").replace("objcopy", "objdump")
+        if not check(str(target[0]), objdump) and mode != "warn":
+            env.Exit(1)
+
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", _post_link)  # noqa: F821
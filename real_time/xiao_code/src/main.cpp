@@ -4,13 +4,16 @@
 #include <string.h>
 #include "leg.hpp"
 #include "can.hpp"
-#include <RP2040_PWM.h>
+#include "log_levels.hpp"
+#include "profiler.hpp"
 #include <hardware/watchdog.h>
 #include "hardware/resets.h"
 
 
 Leg leg;
 void handleCAN();
+void handleSerial();
+void trackLoopPeriod();
 
 void setup() {
   Serial.begin(115200);
@@ -34,6 +37,7 @@ void setup() {
   // leg.setAxisTargetPos(1, 0.00);
   // leg.setAxisTargetPos(2, 0.00);
   leg.rapidMove(0, 100.0, -240.0);
+  leg.startControl();
   
   if (watchdog_caused_reboot()) {
       Serial.println("Watchdog reboot");
@@ -47,19 +51,52 @@ void setup() {
   }
 }
 
+// core1: sensor acquisition only, idles until leg.begin() hands the sensors over
+void setup1() {
+}
+
+void loop1() {
+  leg.sensing.update();
+}
+
+// Control, trajectory and telemetry run as scheduler tasks (see Leg::_registerTasks);
+// loop() only adds the event-driven communication around them
 void loop() {
-  static float dir = 1.0;
+  PROFILE_SECTION(PROFILE_LOOP);
   handleCAN();
-  if (leg.linearMovePerform() == 0) {
-    // leg.linearMoveSetup(150.0 * dir, 112.0, -220.0, 200.0, false);
-    // dir = -dir;
-  }
-  leg.processCommandQueue();
-  leg.runSpeed();
+  handleSerial();
+  leg.scheduler.run();
+  leg.drainTelemetry();
+  trackLoopPeriod();
+}
+
+// Report the worst-case loop() period once a second so blocking regressions show up on the bench
+void trackLoopPeriod()
+{
+    static uint32_t last_loop_us = 0;
+    static uint32_t worst_loop_us = 0;
+    static uint32_t last_report_ms = 0;
+
+    uint32_t now = micros();
+    if (last_loop_us != 0 && now - last_loop_us > worst_loop_us)
+    {
+        worst_loop_us = now - last_loop_us;
+    }
+    last_loop_us = now;
+
+    if (millis() - last_report_ms >= 1000)
+    {
+        last_report_ms = millis();
+        #if LOG_LEVEL >= BASIC_DEBUG
+            Serial.printf("Worst loop period: %lu us\n", worst_loop_us);
+        #endif
+        worst_loop_us = 0;
+    }
 }
 
 void handleCAN()
 {
+    PROFILE_SECTION(PROFILE_CAN);
     if (leg.can)
     {
         if (CAN.available())
@@ -74,3 +111,95 @@ void handleCAN()
         leg.can->poll();
     }
 }
+
+// Single-character bench commands over USB serial
+//   d - flight recorder: send the frozen recording as binary frames (FLIGHT_RECORDER builds)
+//   e - dump encoder I/O diagnostics
+//   j - control period jitter (LEG_CONTROL_ISR builds)
+//   k - kinematics cycle counts (LEG_KINEMATICS_BENCH builds)
+//   l - loop section cycle profile (LOOP_PROFILER builds, counters restart afterwards)
+//   p - controller cycle counts, AxisPID vs PID_v1 (AXIS_PID_BENCH builds)
+//   q - command queue depth, drops and timed start lateness (counters restart afterwards)
+//   r - flight recorder: trigger while recording, re-arm once frozen (FLIGHT_RECORDER builds)
+//   s - scheduler task timing for both cores (core0 counters restart afterwards),
+//       plus queued and dropped binary telemetry records
+//   t - trajectory tracking error and lag per axis (counters restart afterwards)
+//   v - velocity observer lag vs. the legacy filter (AXIS_OBSERVER_BENCH builds)
+//   w - PWM update cycle counts, RP2040_PWM vs. PwmDriver (PWM_DRIVER_BENCH builds, stops the leg)
+//   y - bus time sync state, error and drift (max error restarts afterwards)
+void handleSerial()
+{
+    while (Serial.available() > 0)
+    {
+        char cmd = Serial.read();
+        switch (cmd)
+        {
+#if FLIGHT_RECORDER
+            case 'd':
+                if (!leg.recorder.startDump(RECORDER_DUMP_USB))
+                {
+                    Serial.println("Flight recorder not frozen, 'r' to trigger");
+                }
+                break;
+#endif
+            case 'e':
+                leg.printEncoderDiagnostics();
+                break;
+            case 'j':
+                leg.printControlTiming();
+                break;
+#if LEG_KINEMATICS_BENCH
+            case 'k':
+                leg.benchmarkKinematics();
+                break;
+#endif
+#if LOOP_PROFILER
+            case 'l':
+                Profiler::print();
+                Profiler::reset();
+                break;
+#endif
+#if AXIS_PID_BENCH
+            case 'p':
+                Axis::benchmarkController();
+                break;
+#endif
+            case 'q':
+                leg.command_queue.printStats();
+                leg.command_queue.resetStats();
+                break;
+#if FLIGHT_RECORDER
+            case 'r':
+                leg.triggerOrArmRecorder();
+                break;
+#endif
+            case 's':
+                leg.scheduler.printStats("core0");
+                leg.sensing.scheduler.printStats("core1");
+                leg.scheduler.resetStats();
+#if TELEMETRY_LOGGING_SPACE == TELEMETRY_LOGGING_SPACE_BINARY
+                Serial.printf("telemetry: %u queued, %lu dropped\n", leg.telemetry.getQueued(), leg.telemetry.getDropped());
+#endif
+                break;
+            case 't':
+                leg.printTrackingError();
+                break;
+#if AXIS_OBSERVER_BENCH
+            case 'v':
+                leg.printObserverBench();
+                break;
+#endif
+#if PWM_DRIVER_BENCH
+            case 'w':
+                leg.benchmarkPwm();
+                break;
+#endif
+            case 'y':
+                leg.can->time_sync.print();
+                leg.can->time_sync.resetStats();
+                break;
+            default:
+                break;
+        }
+    }
+}